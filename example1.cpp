@@ -490,6 +490,7 @@ int main(int /* argc */, char ** /* argv */)
     SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
 
     TestWindow *screen = new TestWindow(window, winWidth, winHeight);
+    screen->setEventBatching(true);
 
     Fps fps;
 
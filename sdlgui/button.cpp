@@ -17,16 +17,13 @@
 #include <SDL2/SDL.h>
 #endif
 #include <array>
-#include <thread>
 
 #include "nanovg.h"
-#define NANOVG_RT_IMPLEMENTATION
-#define NANORT_IMPLEMENTATION
 #include "nanovg_rt.h"
 
 NAMESPACE_BEGIN(sdlgui)
 
-struct Button::AsyncTexture
+struct Button::AsyncTexture : public std::enable_shared_from_this<AsyncTexture>
 {
   int id;
   Texture tex;
@@ -36,19 +33,24 @@ struct Button::AsyncTexture
 
   void load(Button* ptr)
   {
-    Button* button = ptr;
-    AsyncTexture* self = this;
-    std::thread tgr([=]() {
-      std::lock_guard<std::mutex> guard(button->theme()->loadMutex);
-
-      NVGcontext *ctx = nullptr;
-      int realw, realh;
-      button->renderBodyTexture(ctx, realw, realh);
+    /* The job works on a snapshot and never touches the widget */
+    int realw, realh;
+    BodyPainter painter = ptr->bodyPainter(realw, realh);
+    Theme* theme = ptr->theme();
+    std::shared_ptr<AsyncTexture> self = shared_from_this();
+    runAsync([=]() {
+      std::lock_guard<std::mutex> guard(theme->loadMutex);
+
+      NVGcontext *ctx = nvgCreateRT(NVG_DEBUG, realw, realh, 0);
+
+      float pxRatio = 1.0f;
+      nvgBeginFrame(ctx, realw, realh, pxRatio);
+      painter(ctx);
+      nvgEndFrame(ctx);
+
       self->tex.rrect = { 0, 0, realw, realh };
       self->ctx = ctx;
     });
-
-    tgr.detach();
   }
 
   void perform(SDL_Renderer* renderer)
@@ -79,6 +81,7 @@ Button::Button(Widget *parent, const std::string &caption, int icon)
       mFlags(NormalButton), mBackgroundColor(Color(0, 0)),
       mTextColor(Color(0, 0)) 
 {
+  mKind |= KindButton;
   _captionTex.dirty = true;
   _iconTex.dirty = true;
 }
@@ -125,8 +128,10 @@ bool Button::mouseButtonEvent(const Vector2i &p, int button, bool down, int modi
                 {
                     for (auto widget : parent()->children()) 
                     {
-                        Button *b = dynamic_cast<Button *>(widget);
-                        if (b != this && b && (b->flags() & RadioButton) && b->mPushed) 
+                        if (widget == this || !widget->isKind(KindButton))
+                            continue;
+                        Button *b = static_cast<Button *>(widget);
+                        if ((b->flags() & RadioButton) && b->mPushed) 
                         {
                             b->mPushed = false;
                             if (b->mChangeCallback)
@@ -152,8 +157,10 @@ bool Button::mouseButtonEvent(const Vector2i &p, int button, bool down, int modi
             {
                 for (auto widget : parent()->children()) 
                 {
-                    Button *b = dynamic_cast<Button *>(widget);
-                    if (b != this && b && (b->flags() & PopupButton) && b->mPushed) 
+                    if (widget == this || !widget->isKind(KindButton))
+                        continue;
+                    Button *b = static_cast<Button *>(widget);
+                    if ((b->flags() & PopupButton) && b->mPushed) 
                     {
                         b->mPushed = false;
                         if (b->mChangeCallback)
@@ -257,6 +264,34 @@ void Button::drawBodyTemp(SDL_Renderer* renderer)
 void Button::drawBody(SDL_Renderer* renderer)
 {
   int id = (mPushed ? 0x1 : 0) + (mMouseFocus ? 0x2 : 0) + (mEnabled ? 0x4 : 0);
+  BodyStyle style = bodyStyle();
+
+  if (mGeometryBody
+      && mTheme->paintGeometry(renderer, absolutePosition(), size(),
+                               [&style](NVGcontext* ctx, int w, int h) { paintBody(ctx, w, h, style); }))
+    return;
+
+  if (skinned())
+  {
+    /* Body only depends on state and background color, so it is composed from a
+       shared nine-patch instead of being rasterized again for every size */
+    SDL_Color bg = mBackgroundColor.toSdlColor();
+    uint64_t state = id | ((uint64_t)bg.r << 8) | ((uint64_t)bg.g << 16)
+                        | ((uint64_t)bg.b << 24) | ((uint64_t)bg.a << 32);
+    int inset = mTheme->mButtonCornerRadius + 3;
+
+    const NinePatch* skin = mTheme->getSkin(renderer, Theme::SkinClass::Button, state,
+                                            Vector2i(2 * inset + 4, 32), PntRect{ inset, inset, inset, inset },
+                                            [&style](NVGcontext* ctx, int w, int h) { paintBody(ctx, w, h, style); });
+    if (skin->tex.tex)
+    {
+      Vector2i ap = absolutePosition();
+      SDL_RenderCopy(renderer, *skin, SDL_Rect{ ap.x, ap.y, width(), height() });
+    }
+    else
+      drawBodyTemp(renderer);
+    return;
+  }
 
   auto atx = std::find_if(_txs.begin(), _txs.end(), [id](AsyncTexturePtr const& p) { return p->id == id; });
 
@@ -358,49 +393,56 @@ Vector2i Button::getTextOffset() const
   return Vector2i(offset, 1 + offset);
 }
 
-void Button::renderBodyTexture(NVGcontext* &ctx, int &realw, int &realh)
+Button::BodyStyle Button::bodyStyle() const
+{
+  return BodyStyle{ mPushed, mMouseFocus, mEnabled, mBackgroundColor, mTextColor, mTheme.get() };
+}
+
+Button::BodyPainter Button::bodyPainter(int &realw, int &realh) const
 {
   int ww = width();
   int hh = height();
-  ctx = nvgCreateRT(NVG_DEBUG, ww + 2, hh + 2, 0);
-
-  float pxRatio = 1.0f;
+  BodyStyle style = bodyStyle();
   realw = ww + 2;
   realh = hh + 2;
-  nvgBeginFrame(ctx, realw, realh, pxRatio);
+  return [=](NVGcontext* ctx) { paintBody(ctx, ww, hh, style); };
+}
 
-  NVGcolor gradTop = mTheme->mButtonGradientTopUnfocused.toNvgColor();
-  NVGcolor gradBot = mTheme->mButtonGradientBotUnfocused.toNvgColor();
+void Button::paintBody(NVGcontext* ctx, int ww, int hh, const BodyStyle& style)
+{
+  const Theme* theme = style.theme;
+  NVGcolor gradTop = theme->mButtonGradientTopUnfocused.toNvgColor();
+  NVGcolor gradBot = theme->mButtonGradientBotUnfocused.toNvgColor();
 
-  if (mPushed)
+  if (style.pushed)
   {
-    gradTop = mTheme->mButtonGradientTopPushed.toNvgColor();
-    gradBot = mTheme->mButtonGradientBotPushed.toNvgColor();
+    gradTop = theme->mButtonGradientTopPushed.toNvgColor();
+    gradBot = theme->mButtonGradientBotPushed.toNvgColor();
   }
-  else if (mMouseFocus && mEnabled)
+  else if (style.focused && style.enabled)
   {
-    gradTop = mTheme->mButtonGradientTopFocused.toNvgColor();
-    gradBot = mTheme->mButtonGradientBotFocused.toNvgColor();
+    gradTop = theme->mButtonGradientTopFocused.toNvgColor();
+    gradBot = theme->mButtonGradientBotFocused.toNvgColor();
   }
 
   nvgBeginPath(ctx);
 
-  nvgRoundedRect(ctx, 1, 1.0f, ww - 2, hh - 2, mTheme->mButtonCornerRadius - 1);
+  nvgRoundedRect(ctx, 1, 1.0f, ww - 2, hh - 2, theme->mButtonCornerRadius - 1);
 
-  if (mBackgroundColor.a() != 0)
+  if (style.background.a() != 0)
   {
-    Color rgb = mBackgroundColor.rgb();
+    Color rgb = style.background.rgb();
     rgb.setAlpha(1.f);
     nvgFillColor(ctx, rgb.toNvgColor());
     nvgFill(ctx);
-    if (mPushed)
+    if (style.pushed)
     {
       gradTop.a = gradBot.a = 0.8f;
     }
     else
     {
-      double v = 1 - mBackgroundColor.a();
-      gradTop.a = gradBot.a = mEnabled ? v : v * .5f + .5f;
+      double v = 1 - style.background.a();
+      gradTop.a = gradBot.a = style.enabled ? v : v * .5f + .5f;
     }
   }
 
@@ -411,16 +453,14 @@ void Button::renderBodyTexture(NVGcontext* &ctx, int &realw, int &realh)
 
   nvgBeginPath(ctx);
   nvgStrokeWidth(ctx, 1.0f);
-  nvgRoundedRect(ctx, 0.5f, (mPushed ? 0.5f : 1.5f), ww - 1, hh - 1 - (mPushed ? 0.0f : 1.0f), mTheme->mButtonCornerRadius);
-  nvgStrokeColor(ctx, mTheme->mBorderLight.toNvgColor());
+  nvgRoundedRect(ctx, 0.5f, (style.pushed ? 0.5f : 1.5f), ww - 1, hh - 1 - (style.pushed ? 0.0f : 1.0f), theme->mButtonCornerRadius);
+  nvgStrokeColor(ctx, theme->mBorderLight.toNvgColor());
   nvgStroke(ctx);
 
   nvgBeginPath(ctx);
-  nvgRoundedRect(ctx, 0.5f, 0.5f, ww - 1, hh - 2, mTheme->mButtonCornerRadius);
-  nvgStrokeColor(ctx, mTheme->mBorderDark.toNvgColor());
+  nvgRoundedRect(ctx, 0.5f, 0.5f, ww - 1, hh - 2, theme->mButtonCornerRadius);
+  nvgStrokeColor(ctx, theme->mBorderDark.toNvgColor());
   nvgStroke(ctx);
-
-  nvgEndFrame(ctx);
 }
 
 void Button::drawTexture(AsyncTexturePtr& texture, SDL_Renderer* renderer)
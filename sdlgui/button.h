@@ -12,6 +12,7 @@
 #pragma once
 
 #include <sdlgui/widget.h>
+#include <functional>
 #include <memory>
 
 NAMESPACE_BEGIN(sdlgui)
@@ -95,7 +96,28 @@ public:
     Button& withIcon(int icon) { setIcon( icon ); return *this; }
 
 protected:
-    virtual void renderBodyTexture(NVGcontext* &ctx, int &realw, int &realh);
+    /// Copy of the state the body painters read, taken on the UI thread
+    struct BodyStyle
+    {
+        bool pushed, focused, enabled;
+        Color background, text;
+        const Theme *theme;
+    };
+    typedef std::function<void(NVGcontext* ctx)> BodyPainter;
+
+    /// Whether the body is drawn from the theme's nine-patch skin; subclasses with a
+    /// size-dependent body (see \ref bodyPainter) return false
+    virtual bool skinned() const { return true; }
+    /**
+     * \brief Painter for the unskinned body texture of \c realw x \c realh pixels.
+     *
+     * It runs on a raster worker, so it must capture copies of the widget state
+     * (see \ref bodyStyle) and never the widget itself.
+     */
+    virtual BodyPainter bodyPainter(int &realw, int &realh) const;
+    BodyStyle bodyStyle() const;
+    /// Paint the default button body into a NanoVG context of the given size
+    static void paintBody(NVGcontext* ctx, int ww, int hh, const BodyStyle& style);
 
     std::string mCaption;
     intptr_t mIcon;
@@ -17,16 +17,13 @@
 #include <sdlgui/theme.h>
 #include <sdlgui/entypo.h>
 #include <array>
-#include <thread>
 
 #include "nanovg.h"
-#define NANOVG_RT_IMPLEMENTATION
-#define NANORT_IMPLEMENTATION
 #include "nanovg_rt.h"
 
 NAMESPACE_BEGIN(sdlgui)
 
-struct CheckBox::AsyncTexture
+struct CheckBox::AsyncTexture : public std::enable_shared_from_this<AsyncTexture>
 {
   int id;
   Texture tex;
@@ -36,15 +33,14 @@ struct CheckBox::AsyncTexture
 
   void load(CheckBox* ptr, bool pushed, bool focused, bool enabled)
   {
-    CheckBox* cb = ptr;
-    AsyncTexture* self = this;
-    std::thread tgr([=]() {
-      Theme* theme = cb->theme();
+    /* The job works on a snapshot and never touches the widget */
+    int ww = ptr->width();
+    int hh = ptr->height();
+    std::shared_ptr<AsyncTexture> self = shared_from_this();
+    runAsync([=]() {
       Color b = Color(0, 0, 0, 180);
       Color c = pushed ? Color(0, 100) : Color(0, 32);
 
-      int ww = cb->width();
-      int hh = cb->height();
       NVGcontext *ctx = nvgCreateRT(NVG_DEBUG, ww + 2, hh + 2, 0);
 
       float pxRatio = 1.0f;
@@ -62,8 +58,6 @@ struct CheckBox::AsyncTexture
       self->tex.rrect = { 0, 0, ww + 2, hh + 2 };
       self->ctx = ctx;
     });
-
-    tgr.detach();
   }
 
   void perform(SDL_Renderer* renderer)
@@ -17,131 +17,233 @@
 #else
 #include <SDL2/SDL.h>
 #endif
+#include <cmath>
 
 NAMESPACE_BEGIN(sdlgui)
 
+namespace
+{
+  const float kPi = 3.14159265358979f;
+
+  /* HSL(h, 1, 0.55) around the ring, indexed by hue in 1/1024 turns */
+  const uint32_t* hueLut()
+  {
+    static uint32_t lut[1024];
+    static bool ready = false;
+    if (!ready)
+    {
+      for (int i = 0; i < 1024; i++)
+      {
+        float h = i / 1024.f * 6.f, l = 0.55f, c = (1 - std::abs(2 * l - 1));
+        float x = c * (1 - std::abs(std::fmod(h, 2.f) - 1)), m = l - c / 2;
+        float r = 0, g = 0, b = 0;
+        switch ((int)h)
+        {
+          case 0: r = c, g = x; break;
+          case 1: r = x, g = c; break;
+          case 2: g = c, b = x; break;
+          case 3: g = x, b = c; break;
+          case 4: r = x, b = c; break;
+          default: r = c, b = x; break;
+        }
+        lut[i] = 0xff000000u | (uint32_t((r + m) * 255 + 0.5f) << 16)
+               | (uint32_t((g + m) * 255 + 0.5f) << 8) | uint32_t((b + m) * 255 + 0.5f);
+      }
+      ready = true;
+    }
+    return lut;
+  }
+
+  inline uint32_t withCoverage(uint32_t argb, float coverage)
+  {
+    uint32_t a = uint32_t(std::min(std::max(coverage, 0.f), 1.f) * (argb >> 24) + 0.5f);
+    return (a << 24) | (argb & 0xffffff);
+  }
+
+  inline uint32_t packColor(float r, float g, float b, float a)
+  {
+    auto c = [](float v) { return uint32_t(std::min(std::max(v, 0.f), 1.f) * 255 + 0.5f); };
+    return (c(a) << 24) | (c(r) << 16) | (c(g) << 8) | c(b);
+  }
+}
+
 ColorWheel::ColorWheel(Widget *parent, const Color& rgb)
     : Widget(parent), mDragRegion(None) 
 {
     setColor(rgb);
 }
 
+ColorWheel::~ColorWheel()
+{
+    if (mTexture)
+        SDL_DestroyTexture(mTexture);
+}
+
 Vector2i ColorWheel::preferredSize(SDL_Renderer *) const
 {
     return { 100, 100 };
 }
 
-void ColorWheel::draw(SDL_Renderer *renderer) 
+void ColorWheel::geometry(float &cx, float &cy, float &r0, float &r1) const
 {
-/*    Widget::draw(ctx);
-
-    if (!mVisible)
-        return;
+    cx = mSize.x * 0.5f;
+    cy = mSize.y * 0.5f;
+    r1 = std::min(mSize.x, mSize.y) * 0.5f - 5.0f;
+    r0 = r1 * .75f;
+}
 
-    float x = mPos.x(),
-          y = mPos.y(),
-          w = mSize.x(),
-          h = mSize.y();
+void ColorWheel::triangle(float r0, Vector2f &tip, Vector2f &white, Vector2f &black) const
+{
+    float r = r0 - 6;
+    float a = mHue * 2 * kPi;
+    auto corner = [&](float angle) { return Vector2f(std::cos(a + angle) * r, std::sin(a + angle) * r); };
+    tip = corner(0);
+    white = corner(120.0f / 180.0f * kPi);
+    black = corner(-120.0f / 180.0f * kPi);
+}
 
-    SDL_Renderer* vg = ctx;
+void ColorWheel::rasterRing()
+{
+    float cx, cy, r0, r1;
+    geometry(cx, cy, r0, r1);
+    const uint32_t* lut = hueLut();
+    int w = mTextureSize.x, h = mTextureSize.y;
+
+    /* Annulus with one pixel of analytic coverage on both edges, plus the 64 alpha outlines */
+    mPixels.assign(size_t(w) * h, 0);
+    for (int y = 0; y < h; y++)
+    {
+        float dy = y + 0.5f - cy;
+        for (int x = 0; x < w; x++)
+        {
+            float dx = x + 0.5f - cx;
+            float d = std::sqrt(dx * dx + dy * dy);
+            if (d < r0 - 1.5f || d > r1 + 1.5f)
+                continue;
+
+            float coverage = std::min(d - r0 + 0.5f, r1 - d + 0.5f);
+            float hue = std::atan2(dy, dx) / (2 * kPi);
+            if (hue < 0)
+                hue += 1;
+            uint32_t c = withCoverage(lut[int(hue * 1024) & 1023], coverage);
+
+            float outline = std::max(1.f - std::abs(d - (r0 - 0.5f)), 1.f - std::abs(d - (r1 + 0.5f)));
+            if (outline > 0 && (c >> 24) < 64)
+                c = withCoverage(0xff000000u, outline * 0.25f);
+            mPixels[size_t(y) * w + x] = c;
+        }
+    }
+}
 
-    int i;
-    float r0, r1, ax,ay, bx,by, cx,cy, aeps, r;
-    float hue = mHue;
-    NVGpaint paint;
+void ColorWheel::rasterTriangle()
+{
+    float cx, cy, r0, r1;
+    geometry(cx, cy, r0, r1);
+    Vector2f tip, white, black;
+    triangle(r0, tip, white, black);
+    Color hue = hue2rgb(mHue);
+    int w = mTextureSize.x;
+
+    /* Only the disk inside the ring changes with the hue */
+    int x0 = std::max(0, int(cx - r0)), x1 = std::min(mTextureSize.x, int(std::ceil(cx + r0)));
+    int y0 = std::max(0, int(cy - r0)), y1 = std::min(mTextureSize.y, int(std::ceil(cy + r0)));
+
+    Vector2f e0 = white - tip, e1 = black - tip;
+    float det = e0.x * e1.y - e0.y * e1.x;
+    float edge = std::sqrt(e0.x * e0.x + e0.y * e0.y);
+    for (int y = y0; y < y1; y++)
+    {
+        float py = y + 0.5f - cy - tip.y;
+        uint32_t* row = mPixels.data() + size_t(y) * w;
+        for (int x = x0; x < x1; x++)
+        {
+            float dx = x + 0.5f - cx, dy = y + 0.5f - cy;
+            if (dx * dx + dy * dy >= (r0 - 1.5f) * (r0 - 1.5f))
+                continue;
+
+            float px = x + 0.5f - cx - tip.x;
+            float lw = (px * e1.y - py * e1.x) / det;
+            float lb = (e0.x * py - e0.y * px) / det;
+            float lt = 1 - lw - lb;
+
+            /* Barycentric distance to the nearest edge, in pixels, for the coverage */
+            float inside = std::min(lt, std::min(lw, lb)) * edge * 0.866f;
+            if (inside < -1.f)
+            {
+                row[x] = 0;
+                continue;
+            }
+            lw = std::min(std::max(lw, 0.f), 1.f);
+            lb = std::min(std::max(lb, 0.f), 1.f);
+            lt = std::max(1.f - lw - lb, 0.f);
+            row[x] = packColor(hue.r() * lt + lw, hue.g() * lt + lw, hue.b() * lt + lw,
+                               std::min(inside + 0.5f, 1.f));
+        }
+    }
+}
 
-    nvgSave(vg);
+void ColorWheel::draw(SDL_Renderer *renderer) 
+{
+    Widget::draw(renderer);
 
-    cx = x + w*0.5f;
-    cy = y + h*0.5f;
-    r1 = (w < h ? w : h) * 0.5f - 5.0f;
-    r0 = r1 * .75f;
+    if (!mVisible || mSize.x <= 10 || mSize.y <= 10)
+        return;
 
-    aeps = 0.5f / r1;   // half a pixel arc length in radians (2pi cancels out).
-
-    for (i = 0; i < 6; i++) {
-        float a0 = (float)i / 6.0f * NVG_PI * 2.0f - aeps;
-        float a1 = (float)(i+1.0f) / 6.0f * NVG_PI * 2.0f + aeps;
-        nvgBeginPath(vg);
-        nvgArc(vg, cx,cy, r0, a0, a1, NVG_CW);
-        nvgArc(vg, cx,cy, r1, a1, a0, NVG_CCW);
-        nvgClosePath(vg);
-        ax = cx + cosf(a0) * (r0+r1)*0.5f;
-        ay = cy + sinf(a0) * (r0+r1)*0.5f;
-        bx = cx + cosf(a1) * (r0+r1)*0.5f;
-        by = cy + sinf(a1) * (r0+r1)*0.5f;
-        paint = nvgLinearGradient(vg, ax, ay, bx, by,
-                                  nvgHSLA(a0 / (NVG_PI * 2), 1.0f, 0.55f, 255),
-                                  nvgHSLA(a1 / (NVG_PI * 2), 1.0f, 0.55f, 255));
-        nvgFillPaint(vg, paint);
-        nvgFill(vg);
+    if (!mTexture || mTextureSize != mSize)
+    {
+        if (mTexture)
+            SDL_DestroyTexture(mTexture);
+        mTextureSize = mSize;
+        mTexture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, mSize.x, mSize.y);
+        SDL_SetTextureBlendMode(mTexture, SDL_BLENDMODE_BLEND);
+        rasterRing();
+        rasterTriangle();
+        mTextureHue = mHue;
+        SDL_UpdateTexture(mTexture, nullptr, mPixels.data(), mSize.x * sizeof(uint32_t));
+    }
+    else if (mTextureHue != mHue)
+    {
+        float cx, cy, r0, r1;
+        geometry(cx, cy, r0, r1);
+        rasterTriangle();
+        mTextureHue = mHue;
+
+        SDL_Rect inner{ std::max(0, int(cx - r0)), std::max(0, int(cy - r0)), 0, 0 };
+        inner.w = std::min(mSize.x, int(std::ceil(cx + r0))) - inner.x;
+        inner.h = std::min(mSize.y, int(std::ceil(cy + r0))) - inner.y;
+        SDL_UpdateTexture(mTexture, &inner, mPixels.data() + size_t(inner.y) * mSize.x + inner.x, mSize.x * sizeof(uint32_t));
     }
 
-    nvgBeginPath(vg);
-    nvgCircle(vg, cx,cy, r0-0.5f);
-    nvgCircle(vg, cx,cy, r1+0.5f);
-    nvgStrokeColor(vg, nvgRGBA(0,0,0,64));
-    nvgStrokeWidth(vg, 1.0f);
-    nvgStroke(vg);
-
-    // Selector
-    nvgSave(vg);
-    nvgTranslate(vg, cx,cy);
-    nvgRotate(vg, hue*NVG_PI*2);
-
-    // Marker on
-    float u = std::max(r1/50, 1.5f);
-          u = std::min(u, 4.f);
-    nvgStrokeWidth(vg, u);
-    nvgBeginPath(vg);
-    nvgRect(vg, r0-1,-2*u,r1-r0+2,4*u);
-    nvgStrokeColor(vg, nvgRGBA(255,255,255,192));
-    nvgStroke(vg);
-
-    paint = nvgBoxGradient(vg, r0-3,-5,r1-r0+6,10, 2,4, nvgRGBA(0,0,0,128), nvgRGBA(0,0,0,0));
-    nvgBeginPath(vg);
-    nvgRect(vg, r0-2-10,-4-10,r1-r0+4+20,8+20);
-    nvgRect(vg, r0-2,-4,r1-r0+4,8);
-    nvgPathWinding(vg, NVG_HOLE);
-    nvgFillPaint(vg, paint);
-    nvgFill(vg);
-
-    // Center triangle
-    r = r0 - 6;
-    ax = cosf(120.0f/180.0f*NVG_PI) * r;
-    ay = sinf(120.0f/180.0f*NVG_PI) * r;
-    bx = cosf(-120.0f/180.0f*NVG_PI) * r;
-    by = sinf(-120.0f/180.0f*NVG_PI) * r;
-    nvgBeginPath(vg);
-    nvgMoveTo(vg, r,0);
-    nvgLineTo(vg, ax, ay);
-    nvgLineTo(vg, bx, by);
-    nvgClosePath(vg);
-    paint = nvgLinearGradient(vg, r, 0, ax, ay, nvgHSLA(hue, 1.0f, 0.5f, 255),
-                              nvgRGBA(255, 255, 255, 255));
-    nvgFillPaint(vg, paint);
-    nvgFill(vg);
-    paint = nvgLinearGradient(vg, (r + ax) * 0.5f, (0 + ay) * 0.5f, bx, by,
-                              nvgRGBA(0, 0, 0, 0), nvgRGBA(0, 0, 0, 255));
-    nvgFillPaint(vg, paint);
-    nvgFill(vg);
-    nvgStrokeColor(vg, nvgRGBA(0, 0, 0, 64));
-    nvgStroke(vg);
-
-    // Select circle on triangle
-    float sx = r*(1 - mWhite - mBlack) + ax*mWhite + bx*mBlack;
-    float sy =                           ay*mWhite + by*mBlack;
-
-    nvgStrokeWidth(vg, u);
-    nvgBeginPath(vg);
-    nvgCircle(vg, sx,sy,2*u);
-    nvgStrokeColor(vg, nvgRGBA(255,255,255,192));
-    nvgStroke(vg);
-
-    nvgRestore(vg);
-
-    nvgRestore(vg);
-    */
+    Vector2i ap = absolutePosition();
+    SDL_Rect dst{ ap.x, ap.y, mSize.x, mSize.y };
+    SDL_RenderCopy(renderer, mTexture, nullptr, &dst);
+
+    /* Selectors are the only per frame drawing */
+    float cx, cy, r0, r1;
+    geometry(cx, cy, r0, r1);
+    float ox = ap.x + cx, oy = ap.y + cy;
+    float u = std::min(std::max(r1 / 50, 1.5f), 4.f);
+    SDL_SetRenderDrawColor(renderer, 255, 255, 255, 192);
+
+    float a = mHue * 2 * kPi, ca = std::cos(a), sa = std::sin(a);
+    auto rotated = [&](float x, float y) {
+        return SDL_Point{ int(std::round(ox + x * ca - y * sa)), int(std::round(oy + x * sa + y * ca)) };
+    };
+    SDL_Point marker[5] = { rotated(r0 - 1, -2 * u), rotated(r1 + 1, -2 * u), rotated(r1 + 1, 2 * u),
+                            rotated(r0 - 1, 2 * u), rotated(r0 - 1, -2 * u) };
+    SDL_RenderDrawLines(renderer, marker, 5);
+
+    Vector2f tip, white, black;
+    triangle(r0, tip, white, black);
+    float sx = ox + tip.x * (1 - mWhite - mBlack) + white.x * mWhite + black.x * mBlack;
+    float sy = oy + tip.y * (1 - mWhite - mBlack) + white.y * mWhite + black.y * mBlack;
+    SDL_Point ring[17];
+    for (int i = 0; i <= 16; i++)
+    {
+        float t = i / 16.f * 2 * kPi;
+        ring[i] = SDL_Point{ int(std::round(sx + std::cos(t) * 2 * u)), int(std::round(sy + std::sin(t) * 2 * u)) };
+    }
+    SDL_RenderDrawLines(renderer, ring, 17);
 }
 
 bool ColorWheel::mouseButtonEvent(const Vector2i &p, int button, bool down,
@@ -168,29 +270,18 @@ bool ColorWheel::mouseDragEvent(const Vector2i &p, const Vector2i &,
 
 ColorWheel::Region ColorWheel::adjustPosition(const Vector2i &p, Region consideredRegions)
 {
- /*   float x = p.x - _pos.x,
-          y = p.y - _pos.y,
-          w = mSize.x,
-          h = mSize.y;
-
-    float cx = w*0.5f;
-    float cy = h*0.5f;
-    float r1 = (w < h ? w : h) * 0.5f - 5.0f;
-    float r0 = r1 * .75f;
-
-    x -= cx;
-    y -= cy;
+    float cx, cy, r0, r1;
+    geometry(cx, cy, r0, r1);
+    float x = p.x - _pos.x - cx,
+          y = p.y - _pos.y - cy;
 
     float mr = std::sqrt(x*x + y*y);
 
     if ((consideredRegions & OuterCircle) &&
         ((mr >= r0 && mr <= r1) || (consideredRegions == OuterCircle))) {
-        if (!(consideredRegions & OuterCircle))
-            return None;
-        mHue = std::atan(y / x);
-        if (x < 0)
-            mHue += NVG_PI;
-        mHue /= 2*NVG_PI;
+        mHue = std::atan2(y, x) / (2 * kPi);
+        if (mHue < 0)
+            mHue += 1;
 
         if (mCallback)
             mCallback(color());
@@ -198,34 +289,20 @@ ColorWheel::Region ColorWheel::adjustPosition(const Vector2i &p, Region consider
         return OuterCircle;
     }
 
-    float r = r0 - 6;
-
-    float ax = std::cos( 120.0f/180.0f*NVG_PI) * r;
-    float ay = std::sin( 120.0f/180.0f*NVG_PI) * r;
-    float bx = std::cos(-120.0f/180.0f*NVG_PI) * r;
-    float by = std::sin(-120.0f/180.0f*NVG_PI) * r;
-
-    typedef Eigen::Matrix<float,2,2>        Matrix2f;
-
-    Eigen::Matrix<float, 2, 3> triangle;
-    triangle << ax,bx,r,
-                ay,by,0;
-    triangle = Eigen::Rotation2D<float>(mHue * 2 * NVG_PI).matrix() * triangle;
-
-    Matrix2f T;
-    T << triangle(0,0) - triangle(0,2), triangle(0,1) - triangle(0,2),
-         triangle(1,0) - triangle(1,2), triangle(1,1) - triangle(1,2);
-    Vector2f pos { x - triangle(0,2), y - triangle(1,2) };
-
-    Vector2f bary = T.colPivHouseholderQr().solve(pos);
-    float l0 = bary[0], l1 = bary[1], l2 = 1 - l0 - l1;
+    /* Barycentric coordinates against the white and black corners, solved in closed form */
+    Vector2f tip, white, black;
+    triangle(r0, tip, white, black);
+    Vector2f e0 = white - tip, e1 = black - tip;
+    float det = e0.x * e1.y - e0.y * e1.x;
+    float px = x - tip.x, py = y - tip.y;
+    float l0 = (px * e1.y - py * e1.x) / det;
+    float l1 = (e0.x * py - e0.y * px) / det;
+    float l2 = 1 - l0 - l1;
     bool triangleTest = l0 >= 0 && l0 <= 1.f && l1 >= 0.f && l1 <= 1.f &&
                         l2 >= 0.f && l2 <= 1.f;
 
     if ((consideredRegions & InnerTriangle) &&
         (triangleTest || consideredRegions == InnerTriangle)) {
-        if (!(consideredRegions & InnerTriangle))
-            return None;
         l0 = std::min(std::max(0.f, l0), 1.f);
         l1 = std::min(std::max(0.f, l1), 1.f);
         l2 = std::min(std::max(0.f, l2), 1.f);
@@ -238,9 +315,8 @@ ColorWheel::Region ColorWheel::adjustPosition(const Vector2i &p, Region consider
             mCallback(color());
         return InnerTriangle;
     }
-    */
-    return None;
 
+    return None;
 }
 
 Color ColorWheel::hue2rgb(float h) const 
@@ -278,16 +354,15 @@ Color ColorWheel::color() const
 
 void ColorWheel::setColor(const Color &rgb) 
 {
-/*    float r = rgb[0], g = rgb[1], b = rgb[2];
+    float r = rgb.r(), g = rgb.g(), b = rgb.b();
 
     float max = std::max({ r, g, b });
     float min = std::min({ r, g, b });
-    float l = (max + min) / 2;
 
+    /* color() mixes a pure hue (max channel 1, min channel 0) with white and black,
+       so the weights follow directly from the extreme channels */
     if (max == min) {
         mHue = 0.;
-        mBlack = 1. - l;
-        mWhite = l;
     } else {
         float d = max - min, h;
         if (max == r)
@@ -296,23 +371,10 @@ void ColorWheel::setColor(const Color &rgb)
             h = (b - r) / d + 2;
         else
             h = (r - g) / d + 4;
-        h /= 6;
-
-        mHue = h;
-
-        Eigen::Matrix<float, 4, 3> M;
-        M.topLeftCorner<3, 1>() = hue2rgb(h).head<3>();
-        M(3, 0) = 1.;
-        M.col(1) = Vector4f{ 0., 0., 0., 1. };
-        M.col(2) = Vector4f{ 1., 1., 1., 1. };
-
-        Vector4f rgb4{ rgb[0], rgb[1], rgb[2], 1. };
-        Vector3f bary = M.colPivHouseholderQr().solve(rgb4);
-
-        mBlack = bary[1];
-        mWhite = bary[2];
+        mHue = h / 6;
     }
-    */
+    mWhite = min;
+    mBlack = 1.f - max;
 }
 
 NAMESPACE_END(sdlgui)
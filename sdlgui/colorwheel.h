@@ -20,6 +20,7 @@ class  ColorWheel : public Widget
 {
 public:
     ColorWheel(Widget *parent, const Color& color = { 1.f, 0.f, 0.f, 1.f });
+    ~ColorWheel();
 
     /// Set the change callback
     std::function<void(const Color &)> callback() const                  { return mCallback;     }
@@ -34,6 +35,7 @@ public:
     void draw(SDL_Renderer *renderer) override;
     bool mouseButtonEvent(const Vector2i &p, int button, bool down, int modifiers);
     bool mouseDragEvent(const Vector2i &p, const Vector2i &rel, int button, int modifiers);
+    bool wantsRawMotion() const override { return mDragRegion != None; }
 
 private:
     enum Region {
@@ -46,12 +48,26 @@ private:
     Color hue2rgb(float h) const;
     Region adjustPosition(const Vector2i &p, Region consideredRegions = Both);
 
+    /// Wheel center and ring radii in widget coordinates
+    void geometry(float &cx, float &cy, float &r0, float &r1) const;
+    /// Triangle corners (hue, white, black) rotated to the current hue, relative to the center
+    void triangle(float r0, Vector2f &tip, Vector2f &white, Vector2f &black) const;
+
+    void rasterRing();
+    void rasterTriangle();
+
 protected:
     float mHue;
     float mWhite;
     float mBlack;
     Region mDragRegion;
     std::function<void(const Color &)> mCallback;
+
+    /* Ring and triangle rasterized on the CPU; the ring only on resize, the triangle when the hue changes */
+    SDL_Texture *mTexture = nullptr;
+    std::vector<uint32_t> mPixels;
+    Vector2i mTextureSize;
+    float mTextureHue = -1.f;
 };
 
 NAMESPACE_END(sdlgui)
@@ -31,6 +31,8 @@
 #include <chrono>
 #include <iostream>
 #include <cmath>
+#include <mutex>
+#include <condition_variable>
 
 #if !defined(_WIN32)
     #include <locale.h>
@@ -197,10 +199,10 @@ std::string file_dialog(const std::vector<std::pair<std::string, std::string>> &
 #endif
 
 void Object::decRef(bool dealloc) const noexcept {
-    --m_refCount;
-    if (m_refCount == 0 && dealloc) {
+    int count = --m_refCount;
+    if (count == 0 && dealloc) {
         delete this;
-    } else if (m_refCount < 0) {
+    } else if (count < 0) {
         fprintf(stderr, "Internal error: Object reference count < 0!\n");
         abort();
     }
@@ -208,5 +210,44 @@ void Object::decRef(bool dealloc) const noexcept {
 
 Object::~Object() { }
 
+namespace internal
+{
+  std::mutex asyncMutex;
+  std::condition_variable asyncDone;
+  int asyncPending = 0;
+  uint64_t asyncStarted = 0;
+}
+
+void runAsync(const std::function<void()>& job)
+{
+  {
+    std::lock_guard<std::mutex> guard(internal::asyncMutex);
+    internal::asyncPending++;
+    internal::asyncStarted++;
+  }
+
+  std::thread tgr([job]() {
+    job();
+
+    std::lock_guard<std::mutex> guard(internal::asyncMutex);
+    if (--internal::asyncPending == 0)
+      internal::asyncDone.notify_all();
+  });
+
+  tgr.detach();
+}
+
+uint64_t asyncJobsStarted()
+{
+  std::lock_guard<std::mutex> guard(internal::asyncMutex);
+  return internal::asyncStarted;
+}
+
+void waitAsyncJobs()
+{
+  std::unique_lock<std::mutex> lock(internal::asyncMutex);
+  internal::asyncDone.wait(lock, []() { return internal::asyncPending == 0; });
+}
+
 NAMESPACE_END(sdlgui)
 
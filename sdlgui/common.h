@@ -8,6 +8,7 @@
 #include <functional>
 #include <atomic>
 #include <vector>
+#include <memory>
 #include <math.h>
 #include <assert.h>
 #include <istream>
@@ -70,6 +71,73 @@ typedef std::vector<ImageInfo> ListImages;
 /// Load a directory of PNG images and upload them to the GPU (suitable for use with ImagePanel)
 ListImages loadImageDirectory(SDL_Renderer* renderer, const std::string &path);
 
+/**
+ * \brief Asynchronous counterpart of \ref loadImageDirectory that keeps thumbnails only.
+ *
+ * The directory is listed in the constructor, so \ref images has one entry
+ * per PNG file from the start, with a null texture. Worker threads decode the
+ * files with IMG_Load and scale each one down until it just covers a
+ * \c thumbSize square. \ref upload runs on the UI thread and turns at most
+ * \c budget finished thumbnails into textures per call. The loader owns the
+ * textures it creates.
+ *
+ * With a \c cachePath the thumbnails are also kept in a single pack file,
+ * keyed by path, modification time and file size. The pack is memory
+ * mapped on the next run: files that did not change are uploaded straight
+ * from the mapping and only new or modified files are decoded. The pack is
+ * rewritten, via a temporary file, once those decodes finish.
+ *
+ * With \c onDemand nothing is decoded until \ref request is called for an
+ * entry, and \ref release drops its texture again. ImagePanel uses this to
+ * keep only the rows near the visible area resident.
+ */
+class ImageDirectoryLoader
+{
+public:
+  ImageDirectoryLoader(const std::string &path, int thumbSize = 64, const std::string &cachePath = "",
+                       bool onDemand = false);
+  ~ImageDirectoryLoader();
+
+  const ListImages& images() const { return mImages; }
+  bool onDemand() const { return mOnDemand; }
+
+  /// Queue the thumbnail of an entry; the latest on demand request is decoded first
+  void request(int index);
+  /// Destroy the texture of an entry, or cancel its request when no worker has picked it up yet
+  void release(int index);
+  bool resident(int index) const { return mStatus[index] == Resident; }
+
+  /// Upload up to \c budget decoded thumbnails; indices of the updated entries are appended to \c updated
+  int upload(SDL_Renderer* renderer, int budget, std::vector<int>* updated = nullptr);
+
+  /// True when no request is queued, being decoded or waiting for upload
+  bool finished() const;
+
+private:
+  enum Status : uint8_t { Idle, Queued, Resident, Failed };
+
+  struct State;
+  std::shared_ptr<State> mState;
+  ListImages mImages;
+  std::vector<uint8_t> mStatus;
+  bool mOnDemand;
+};
+
+/**
+* \brief Storage of \ref Object reference counts.
+*
+* Widgets are created, referenced and destroyed on the UI thread only; the
+* async raster jobs work on value snapshots and never copy a \ref ref. Builds
+* that guarantee this can define SDLGUI_NONATOMIC_REFCOUNT (CMake option
+* NANOGUI_ATOMIC_REFCOUNT=OFF) to drop the atomic read-modify-write from
+* every reference count change.
+*/
+#if defined(SDLGUI_NONATOMIC_REFCOUNT)
+typedef int RefCount;
+#else
+typedef std::atomic<int> RefCount;
+#endif
+
 /**
 * \class Object object.h sdlgui/object.h
 *
@@ -103,7 +171,7 @@ protected:
   */
   virtual ~Object();
 private:
-  mutable std::atomic<int> m_refCount{ 0 };
+  mutable RefCount m_refCount{ 0 };
 };
 
 /**
@@ -336,6 +404,13 @@ SDL_Rect pntrect2srect(const PntRect& frect);
 
 std::string  file_dialog(const std::vector<std::pair<std::string, std::string>> &filetypes, bool save);
 
+/// Run a widget texture raster job on a detached worker thread
+void runAsync(const std::function<void()>& job);
+/// Total number of jobs started with \ref runAsync
+uint64_t asyncJobsStarted();
+/// Block until every job started with \ref runAsync has finished
+void waitAsyncJobs();
+
 
 namespace math
 {
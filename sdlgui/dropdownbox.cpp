@@ -15,8 +15,6 @@
 #include <array>
 
 #include "nanovg.h"
-#define NANOVG_RT_IMPLEMENTATION
-#define NANORT_IMPLEMENTATION
 #include "nanovg_rt.h"
 
 NAMESPACE_BEGIN(sdlgui)
@@ -29,96 +27,96 @@ public:
   DropdownListItem(Widget* parent, const std::string& str, bool inlist=true)
     : Button(parent, str), mInlist(inlist) {}
 
-  void renderBodyTexture(NVGcontext* &ctx, int &realw, int &realh) override
+  bool skinned() const override { return false; }
+
+  BodyPainter bodyPainter(int &realw, int &realh) const override
   {
     int ww = width();
     int hh = height();
-    ctx = nvgCreateRT(NVG_DEBUG, ww + 2, hh + 2, 0);
-
-    float pxRatio = 1.0f;
+    BodyStyle style = bodyStyle();
+    bool inlist = mInlist;
     realw = ww + 2;
     realh = hh + 2;
-    nvgBeginFrame(ctx, realw, realh, pxRatio);
 
-    if (!mInlist)
-    {
-      Color gradTop = mTheme->mButtonGradientTopPushed;
-      Color gradBot = mTheme->mButtonGradientBotPushed;
+    return [=](NVGcontext* ctx) {
+      const Theme* theme = style.theme;
+      if (!inlist)
+      {
+        Color gradTop = theme->mButtonGradientTopPushed;
+        Color gradBot = theme->mButtonGradientBotPushed;
 
-      nvgBeginPath(ctx);
+        nvgBeginPath(ctx);
 
-      nvgRoundedRect(ctx, 1, 1, ww - 2,  hh - 2, mTheme->mButtonCornerRadius - 1);
+        nvgRoundedRect(ctx, 1, 1, ww - 2,  hh - 2, theme->mButtonCornerRadius - 1);
 
-      if (mBackgroundColor.a() != 0) 
-      {
-        Color rgb = mBackgroundColor.rgb();
-        rgb.setAlpha(1.f);
-        nvgFillColor(ctx, rgb.toNvgColor());
-        nvgFill(ctx);
-        gradTop.a() = gradBot.a() = 0.8f;
-      }
+        if (style.background.a() != 0) 
+        {
+          Color rgb = style.background.rgb();
+          rgb.setAlpha(1.f);
+          nvgFillColor(ctx, rgb.toNvgColor());
+          nvgFill(ctx);
+          gradTop.a() = gradBot.a() = 0.8f;
+        }
 
-      NVGpaint bg = nvgLinearGradient(ctx, 0, 0, 0, hh, gradTop.toNvgColor(), gradBot.toNvgColor());
+        NVGpaint bg = nvgLinearGradient(ctx, 0, 0, 0, hh, gradTop.toNvgColor(), gradBot.toNvgColor());
 
-      nvgFillPaint(ctx, bg);
-      nvgFill(ctx);
+        nvgFillPaint(ctx, bg);
+        nvgFill(ctx);
 
-      nvgBeginPath(ctx);
-      nvgStrokeWidth(ctx, 1.0f);
-      nvgRoundedRect(ctx, 0.5f, 0.5f, ww- 1, hh, mTheme->mButtonCornerRadius);
-      nvgStrokeColor(ctx, mTheme->mBorderLight.toNvgColor());
-      nvgStroke(ctx);
+        nvgBeginPath(ctx);
+        nvgStrokeWidth(ctx, 1.0f);
+        nvgRoundedRect(ctx, 0.5f, 0.5f, ww- 1, hh, theme->mButtonCornerRadius);
+        nvgStrokeColor(ctx, theme->mBorderLight.toNvgColor());
+        nvgStroke(ctx);
 
-      nvgBeginPath(ctx);
-      nvgRoundedRect(ctx, 0.5f, 0.5f, ww - 1, hh, mTheme->mButtonCornerRadius);
-      nvgStrokeColor(ctx, mTheme->mBorderDark.toNvgColor());
-      nvgStroke(ctx);
-    }
-    else
-    {
-      if (mMouseFocus && mEnabled)
+        nvgBeginPath(ctx);
+        nvgRoundedRect(ctx, 0.5f, 0.5f, ww - 1, hh, theme->mButtonCornerRadius);
+        nvgStrokeColor(ctx, theme->mBorderDark.toNvgColor());
+        nvgStroke(ctx);
+      }
+      else
       {
-        Color gradTop = mTheme->mButtonGradientTopFocused;
-        Color gradBot = mTheme->mButtonGradientBotFocused;
+        if (style.focused && style.enabled)
+        {
+          Color gradTop = theme->mButtonGradientTopFocused;
+          Color gradBot = theme->mButtonGradientBotFocused;
 
-        nvgBeginPath(ctx);
+          nvgBeginPath(ctx);
 
-        nvgRoundedRect(ctx, 1, 1, ww - 2, hh - 2, mTheme->mButtonCornerRadius - 1);
+          nvgRoundedRect(ctx, 1, 1, ww - 2, hh - 2, theme->mButtonCornerRadius - 1);
 
-        if (mBackgroundColor.a() != 0) 
-        {
-          Color rgb = mBackgroundColor.rgb();
-          rgb.setAlpha(1.f);
-          nvgFillColor(ctx, rgb.toNvgColor());
-          nvgFill(ctx);
-          if (mPushed)
-            gradTop.a() = gradBot.a() = 0.8f;
-          else 
+          if (style.background.a() != 0) 
           {
-            double v = 1 - mBackgroundColor.a();
-            gradTop.a() = gradBot.a() = mEnabled ? v : v * .5f + .5f;
+            Color rgb = style.background.rgb();
+            rgb.setAlpha(1.f);
+            nvgFillColor(ctx, rgb.toNvgColor());
+            nvgFill(ctx);
+            if (style.pushed)
+              gradTop.a() = gradBot.a() = 0.8f;
+            else 
+            {
+              double v = 1 - style.background.a();
+              gradTop.a() = gradBot.a() = style.enabled ? v : v * .5f + .5f;
+            }
           }
-        }
 
-        NVGpaint bg = nvgLinearGradient(ctx, 0, 0, 0, hh, gradTop.toNvgColor(), gradBot.toNvgColor());
+          NVGpaint bg = nvgLinearGradient(ctx, 0, 0, 0, hh, gradTop.toNvgColor(), gradBot.toNvgColor());
 
-        nvgFillPaint(ctx, bg);
-        nvgFill(ctx); 
+          nvgFillPaint(ctx, bg);
+          nvgFill(ctx); 
+        }
       }
-    }
 
-    if (mPushed && mInlist)
-    {
-      Color textColor = mTextColor.a() == 0 ? mTheme->mTextColor : mTextColor;
-      Vector2f center = mSize.cast<float>() * 0.5f;
+      if (style.pushed && inlist)
+      {
+        Color textColor = style.text.a() == 0 ? theme->mTextColor : style.text;
 
-      nvgBeginPath(ctx);
-      nvgCircle(ctx, width() * 0.05f, center.y, 2);
-      nvgFillColor(ctx, textColor.toNvgColor());
-      nvgFill(ctx);
-    }
-    
-    nvgEndFrame(ctx);
+        nvgBeginPath(ctx);
+        nvgCircle(ctx, ww * 0.05f, hh * 0.5f, 2);
+        nvgFillColor(ctx, textColor.toNvgColor());
+        nvgFill(ctx);
+      }
+    };
   }
 
   Vector2i getTextOffset() const override { return Vector2i(0, 0); }
@@ -148,7 +146,7 @@ public:
   void refreshRelativePlacement() override
   {
     Popup::refreshRelativePlacement();
-    mVisible &= mParentWindow->visibleRecursive();
+    setVisible(mVisible && mParentWindow->visibleRecursive());
 
     Widget *widget = this;
     while (widget->parent() != nullptr)
@@ -156,8 +154,10 @@ public:
     Screen *screen = (Screen *)widget;
     Vector2i screenSize = screen->size();
 
-    _pos = mParentWindow->position() + mAnchorPos;
-    _pos = Vector2i(_pos.x, std::min(_pos.y, screen->size().y - mSize.y));
+    Vector2i pos = mParentWindow->position() + mAnchorPos;
+    pos = Vector2i(pos.x, std::min(pos.y, screen->size().y - mSize.y));
+    if (pos != _pos)
+      setPosition(pos);
   }
 
   void updateCaption(const std::string& caption)
@@ -188,46 +188,40 @@ public:
   float path = 0.f;
   int clamp(int val, int min, int max) { return val < min ? min : (val > max ? max : val); }
 
-  void rendereBodyTexture(NVGcontext* &ctx, int& realw, int& realh, int dx) override
+  BodyPainter bodyPainter(int& realw, int& realh, int dx) const override
   {
     int ds = 1, cr = mTheme->mWindowCornerRadius;
     int ww = mFixedSize.x > 0 ? mFixedSize.x : mSize.x;
     int hh = height();
     int dy = 0;
     int xadd = 1;
-
-    int headerH = mChildren[0]->height();
-    int realH = clamp(mSize.y * path, headerH, mSize.y);
+    Color dropShadow = mTheme->mDropShadow;
+    Color transparent = mTheme->mTransparent;
+    Color fill = mTheme->mWindowPopup;
 
     Vector2i offset(dx + ds, dy + ds);
 
     realw = ww + 2 * ds + dx + xadd; //with + 2*shadow + 2*boder + offset
     realh = hh + 2 * ds + dy + xadd;
+    int rw = realw, rh = realh;
 
-    ctx = nvgCreateRT(NVG_DEBUG, realw, realh, 0);
+    return [=](NVGcontext* ctx) {
+      // Draw a drop shadow 
+      NVGpaint shadowPaint = nvgBoxGradient(ctx, 0, 0, rw, rh, cr * 2, ds * 2,
+                                            dropShadow.toNvgColor(), transparent.toNvgColor());
 
-    float pxRatio = 1.0f;
-    nvgBeginFrame(ctx, realw, realh, pxRatio);
-
-    // Draw a drop shadow 
-    NVGpaint shadowPaint = nvgBoxGradient(ctx, 0, 0, realw, realh, cr * 2, ds * 2,
-                                          mTheme->mDropShadow.toNvgColor(), mTheme->mTransparent.toNvgColor());
-
-    nvgBeginPath(ctx);
-    nvgRect(ctx, 0, 0, ww + 2 * ds, hh + 2 * ds);
-    //nvgRoundedRect(ctx, 0, 0, ww + 2 * ds, hh + 2 * ds, cr);
-    //nvgPathWinding(ctx, NVG_HOLE);
-    nvgFillPaint(ctx, shadowPaint);
-    nvgFill(ctx);
-
-    // Draw window
-    nvgBeginPath(ctx);
-    nvgRect(ctx, offset.x, offset.y, ww, hh);
+      nvgBeginPath(ctx);
+      nvgRect(ctx, 0, 0, ww + 2 * ds, hh + 2 * ds);
+      nvgFillPaint(ctx, shadowPaint);
+      nvgFill(ctx);
 
-    nvgFillColor(ctx, mTheme->mWindowPopup.toNvgColor());
-    nvgFill(ctx);
+      // Draw window
+      nvgBeginPath(ctx);
+      nvgRect(ctx, offset.x, offset.y, ww, hh);
 
-    nvgEndFrame(ctx);
+      nvgFillColor(ctx, fill.toNvgColor());
+      nvgFill(ctx);
+    };
   }
 
   Vector2i getOverrideBodyPos() override
@@ -10,30 +10,162 @@
 
 #include <sdlgui/graph.h>
 #include <sdlgui/theme.h>
-#include <thread>
 
 #include "nanovg.h"
-#define NANOVG_RT_IMPLEMENTATION
-#define NANORT_IMPLEMENTATION
 #include "nanovg_rt.h"
 
+#include <atomic>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(_WIN32)
+#include <SDL.h>
+#else
+#include <SDL2/SDL.h>
+#endif
+
 NAMESPACE_BEGIN(sdlgui)
 
-struct Graph::AsyncTexture
+struct Graph::Stream
+{
+  /* Producers claim a position with fetch_add and publish it in one 64-bit store that
+     carries the low 32 bits of position + 1 next to the value bits, so a reader never
+     pairs a value with the sequence of another lap. A slow reader simply loses the
+     samples that were overwritten in the meantime */
+  struct Slot
+  {
+    std::atomic<uint64_t> word{ 0 };
+  };
+
+  std::unique_ptr<Slot[]> slots;
+  size_t capacity;
+  std::atomic<uint64_t> head{ 0 };
+  uint64_t tail = 0;
+
+  /* Pixel columns, used as a ring: the oldest column is at 'cursor' */
+  int samplesPerColumn;
+  int pending = 0;
+  float colMin = 0.f, colMax = 0.f, lastValue = 0.f;
+  int cursor = 0;
+  int texW = 0, texH = 0;
+  std::vector<uint32_t> pixels;
+  SDL_Texture* tex = nullptr;
+  uint32_t background = 0, fill = 0, stroke = 0;
+
+  Stream(size_t cap, int perColumn)
+    : slots(new Slot[cap]), capacity(cap), samplesPerColumn(perColumn) {}
+
+  ~Stream()
+  {
+    if (tex)
+      SDL_DestroyTexture(tex);
+  }
+
+  void push(float v)
+  {
+    uint64_t pos = head.fetch_add(1, std::memory_order_relaxed);
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    slots[pos % capacity].word.store((uint64_t(uint32_t(pos + 1)) << 32) | bits, std::memory_order_release);
+  }
+
+  /* Calls fn for every published sample not consumed yet, oldest first */
+  template<typename Fn>
+  void drain(Fn fn)
+  {
+    uint64_t h = head.load(std::memory_order_acquire);
+    if (h - tail > capacity)
+      tail = h - capacity;
+
+    for (; tail < h; tail++)
+    {
+      uint64_t word = slots[tail % capacity].word.load(std::memory_order_acquire);
+      int32_t lap = int32_t(uint32_t(word >> 32) - uint32_t(tail + 1));
+      if (lap < 0)
+        break; // claimed but not written yet, retry next frame
+      if (lap > 0)
+        continue; // already overwritten by a newer sample
+
+      uint32_t bits = uint32_t(word);
+      float v;
+      memcpy(&v, &bits, sizeof(v));
+      fn(v);
+    }
+  }
+
+  static uint32_t argb(const SDL_Color& c)
+  {
+    return (uint32_t(c.a) << 24) | (uint32_t(c.r) << 16) | (uint32_t(c.g) << 8) | c.b;
+  }
+
+  /* Straight alpha 'top over bottom' */
+  static SDL_Color over(const SDL_Color& top, const SDL_Color& bottom)
+  {
+    float ta = top.a / 255.f, ba = bottom.a / 255.f;
+    float a = ta + ba * (1 - ta);
+    if (a <= 0)
+      return SDL_Color{ 0, 0, 0, 0 };
+    auto mix = [&](Uint8 t, Uint8 b) { return Uint8((t * ta + b * ba * (1 - ta)) / a + 0.5f); };
+    return SDL_Color{ mix(top.r, bottom.r), mix(top.g, bottom.g), mix(top.b, bottom.b), Uint8(a * 255 + 0.5f) };
+  }
+
+  void resize(SDL_Renderer* renderer, int ww, int hh, const Color& bg, const Color& fg)
+  {
+    if (tex)
+      SDL_DestroyTexture(tex);
+    texW = ww;
+    texH = hh;
+    cursor = 0;
+
+    SDL_Color b = bg.toSdlColor();
+    background = argb(b);
+    fill = argb(over(fg.toSdlColor(), b));
+    stroke = argb(over(Color(100, 255).toSdlColor(), b));
+
+    pixels.assign(size_t(ww) * hh, background);
+    tex = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, ww, hh);
+    SDL_SetTextureBlendMode(tex, SDL_BLENDMODE_BLEND);
+    SDL_UpdateTexture(tex, nullptr, pixels.data(), ww * sizeof(uint32_t));
+  }
+
+  /* Rasterize one column: filled below the envelope, stroked from the previous value */
+  void rasterColumn(int x, float vmin, float vmax)
+  {
+    auto toY = [&](float v) { return int((1.f - std::min(std::max(v, 0.f), 1.f)) * (texH - 1) + 0.5f); };
+    int yTop = toY(vmax), yBottom = toY(vmin), yPrev = toY(lastValue);
+    int lineTop = std::min(yTop, yPrev), lineBottom = std::max(yBottom, yPrev);
+
+    uint32_t* p = pixels.data() + x;
+    for (int y = 0; y < texH; y++, p += texW)
+      *p = (y >= lineTop && y <= lineBottom) ? stroke : (y > yTop ? fill : background);
+  }
+
+  void upload(int x, int count)
+  {
+    if (count <= 0)
+      return;
+    SDL_Rect r{ x, 0, count, texH };
+    SDL_UpdateTexture(tex, &r, pixels.data() + x, texW * sizeof(uint32_t));
+  }
+};
+
+struct Graph::AsyncTexture : public std::enable_shared_from_this<AsyncTexture>
 {
   Texture tex;
   NVGcontext* ctx = nullptr;
 
   void load(Graph* ptr)
   {
-    Graph* graph = ptr;
-    AsyncTexture* self = this;
-
-    std::thread tgr([=]() {
-      Theme* theme = graph->theme();
+    /* The job works on a snapshot of the decimated plot and never touches the widget */
+    int ww = ptr->width();
+    int hh = ptr->height();
+    Color background = ptr->backgroundColor();
+    Color foreground = ptr->foregroundColor();
+    auto points = ptr->plotPoints();
+    std::shared_ptr<AsyncTexture> self = shared_from_this();
 
-      int ww = graph->width();
-      int hh = graph->height();
+    runAsync([=]() {
       NVGcontext *ctx = nvgCreateRT(NVG_DEBUG, ww, hh, 0);
 
       float pxRatio = 1.0f;
@@ -41,36 +173,32 @@ struct Graph::AsyncTexture
 
       nvgBeginPath(ctx);
       nvgRect(ctx, 0, 0, ww, hh);
-      nvgFillColor(ctx, graph->backgroundColor().toNvgColor());
+      nvgFillColor(ctx, background.toNvgColor());
       nvgFill(ctx);
 
-      if (graph->values().size() < 2)
-        return;
-
-      nvgBeginPath(ctx);
-      nvgMoveTo(ctx, 0, 0 + hh);
-      auto& values = graph->values();
-      for (size_t i = 0; i < (size_t)values.size(); i++) 
+      if (points.size() >= 2)
       {
-        float value = values[i];
-        float vx = 0 + i * ww / (float)(values.size() - 1);
-        float vy = 0 + (1 - value) * hh;
-        nvgLineTo(ctx, vx, vy);
-      }
+        nvgBeginPath(ctx);
+        nvgMoveTo(ctx, 0, 0 + hh);
+        for (const Vector2f& p : points)
+        {
+          float vx = 0 + p.x * ww;
+          float vy = 0 + (1 - p.y) * hh;
+          nvgLineTo(ctx, vx, vy);
+        }
 
-      nvgLineTo(ctx, 0 + ww, 0 + hh);
-      nvgStrokeColor(ctx, Color(100, 255).toNvgColor());
-      nvgStroke(ctx);
-      nvgFillColor(ctx, graph->foregroundColor().toNvgColor());
-      nvgFill(ctx);
+        nvgLineTo(ctx, 0 + ww, 0 + hh);
+        nvgStrokeColor(ctx, Color(100, 255).toNvgColor());
+        nvgStroke(ctx);
+        nvgFillColor(ctx, foreground.toNvgColor());
+        nvgFill(ctx);
+      }
 
       nvgEndFrame(ctx);
 
       self->tex.rrect = { 0, 0, ww, hh };
       self->ctx = ctx;
     });
-
-    tgr.detach();
   }
 
   void perform(SDL_Renderer* renderer)
@@ -109,24 +237,225 @@ Vector2i Graph::preferredSize(SDL_Renderer *) const
     return Vector2i(180, 45);
 }
 
+void Graph::decimateMinMax(const float *values, size_t count, int columns, std::vector<Vector2f> &out)
+{
+    out.clear();
+    out.reserve(columns * 2);
+    for (int c = 0; c < columns; c++)
+    {
+        size_t begin = count * c / columns;
+        size_t end = count * (c + 1) / columns;
+        if (begin >= end)
+            continue;
+
+        /* Four independent accumulators, so the compiler can keep them in vector lanes */
+        const float *v = values + begin;
+        size_t n = end - begin;
+        float mn[4] = { v[0], v[0], v[0], v[0] };
+        float mx[4] = { v[0], v[0], v[0], v[0] };
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4)
+            for (int k = 0; k < 4; k++)
+            {
+                mn[k] = v[i + k] < mn[k] ? v[i + k] : mn[k];
+                mx[k] = v[i + k] > mx[k] ? v[i + k] : mx[k];
+            }
+        for (; i < n; i++)
+        {
+            mn[0] = std::min(mn[0], v[i]);
+            mx[0] = std::max(mx[0], v[i]);
+        }
+        float lo = std::min(std::min(mn[0], mn[1]), std::min(mn[2], mn[3]));
+        float hi = std::max(std::max(mx[0], mx[1]), std::max(mx[2], mx[3]));
+
+        /* End the column on the extreme nearest to its last sample, so the segment
+           into the next column stays short */
+        float x = (c + 0.5f) / columns;
+        bool endHigh = (hi - v[n - 1]) < (v[n - 1] - lo);
+        out.push_back(Vector2f(x, endHigh ? lo : hi));
+        if (hi != lo)
+            out.push_back(Vector2f(x, endHigh ? hi : lo));
+    }
+}
+
+void Graph::decimateLTTB(const float *values, size_t count, size_t threshold, std::vector<Vector2f> &out)
+{
+    out.clear();
+    float scale = 1.f / (count - 1);
+    if (threshold >= count || threshold < 3)
+    {
+        out.reserve(count);
+        for (size_t i = 0; i < count; i++)
+            out.push_back(Vector2f(i * scale, values[i]));
+        return;
+    }
+
+    out.reserve(threshold);
+    out.push_back(Vector2f(0.f, values[0]));
+
+    /* Inner buckets share the samples between the fixed first and last points */
+    double every = double(count - 2) / (threshold - 2);
+    size_t a = 0;
+    for (size_t b = 0; b < threshold - 2; b++)
+    {
+        size_t nextBegin = size_t((b + 1) * every) + 1;
+        size_t nextEnd = std::min(size_t((b + 2) * every) + 1, count);
+        float avgX = 0.f, avgY = 0.f;
+        for (size_t i = nextBegin; i < nextEnd; i++)
+        {
+            avgX += float(i);
+            avgY += values[i];
+        }
+        size_t nextCount = std::max<size_t>(nextEnd - nextBegin, 1);
+        avgX /= nextCount;
+        avgY /= nextCount;
+
+        size_t begin = size_t(b * every) + 1;
+        size_t end = size_t((b + 1) * every) + 1;
+        float ax = float(a), ay = values[a];
+        float bestArea = -1.f;
+        size_t best = begin;
+        for (size_t i = begin; i < end; i++)
+        {
+            float area = std::abs((ax - avgX) * (values[i] - ay) - (ax - float(i)) * (avgY - ay));
+            if (area > bestArea)
+            {
+                bestArea = area;
+                best = i;
+            }
+        }
+        out.push_back(Vector2f(best * scale, values[best]));
+        a = best;
+    }
+
+    out.push_back(Vector2f(1.f, values[count - 1]));
+}
+
+const std::vector<Vector2f> &Graph::plotPoints()
+{
+    int ww = std::max(width(), 1);
+    if (mPlotWidth == ww && !mValuesDirty)
+        return mPlot;
+
+    mPlotWidth = ww;
+    size_t count = mValues.size();
+    if (count < 2)
+        mPlot.clear();
+    else if (mDecimation == Decimation::MinMax && count > size_t(ww) * 2)
+        decimateMinMax(mValues.data(), count, ww, mPlot);
+    else if (mDecimation == Decimation::LTTB)
+        decimateLTTB(mValues.data(), count, size_t(ww) * 2, mPlot);
+    else
+        decimateLTTB(mValues.data(), count, count, mPlot);
+    return mPlot;
+}
+
+void Graph::setStreaming(size_t capacity, int samplesPerColumn)
+{
+    if (capacity == 0)
+    {
+        mStream.reset();
+        mValuesDirty = true;
+        return;
+    }
+    mStream = std::make_shared<Stream>(capacity, std::max(1, samplesPerColumn));
+}
+
+void Graph::push(float value)
+{
+    if (mStream)
+        mStream->push(value);
+}
+
+void Graph::drawStream(SDL_Renderer *renderer, const Vector2i &ap)
+{
+    Stream &s = *mStream;
+    int ww = width(), hh = height();
+    if (ww <= 0 || hh <= 0)
+        return;
+    if (!s.tex || s.texW != ww || s.texH != hh)
+        s.resize(renderer, ww, hh, mBackgroundColor, mForegroundColor);
+
+    /* Fold new samples into columns, remembering which columns changed */
+    int first = s.cursor, added = 0;
+    s.drain([&](float v) {
+        if (s.pending == 0)
+            s.colMin = s.colMax = v;
+        s.colMin = std::min(s.colMin, v);
+        s.colMax = std::max(s.colMax, v);
+        if (++s.pending < s.samplesPerColumn)
+            return;
+
+        s.rasterColumn(s.cursor, s.colMin, s.colMax);
+        s.lastValue = v;
+        s.pending = 0;
+        s.cursor = (s.cursor + 1) % ww;
+        added++;
+    });
+
+    if (added >= ww)
+        s.upload(0, ww);
+    else if (first + added <= ww)
+        s.upload(first, added);
+    else
+    {
+        s.upload(first, ww - first);
+        s.upload(0, first + added - ww);
+    }
+
+    /* Oldest column first: [cursor, ww) then [0, cursor) */
+    SDL_Rect src1{ s.cursor, 0, ww - s.cursor, hh }, dst1{ ap.x, ap.y, ww - s.cursor, hh };
+    SDL_RenderCopy(renderer, s.tex, &src1, &dst1);
+    if (s.cursor > 0)
+    {
+        SDL_Rect src2{ 0, 0, s.cursor, hh }, dst2{ ap.x + ww - s.cursor, ap.y, s.cursor, hh };
+        SDL_RenderCopy(renderer, s.tex, &src2, &dst2);
+    }
+}
+
 void Graph::draw(SDL_Renderer *renderer) 
 {
     Widget::draw(renderer);
 
     Vector2i ap = absolutePosition();
     
-    if (_atx)
+    if (mStream)
     {
-      Vector2i ap = absolutePosition();
-      _atx->perform(renderer);
-      SDL_RenderCopy(renderer, _atx->tex, ap);
+      drawStream(renderer, ap);
     }
     else
     {
-      _atx = std::make_shared<AsyncTexture>();
-      _atx->load(this);
+      /* Keep showing the previous plot until the new raster is ready; at most one job in flight */
+      if (_atx && _atx->tex.tex && (_atx->tex.w() != width() || _atx->tex.h() != height()))
+        mValuesDirty = true;
+      if (mValuesDirty && !_atxPending)
+      {
+        _atxPending = std::make_shared<AsyncTexture>();
+        _atxPending->load(this);
+        mValuesDirty = false;
+      }
+
+      if (_atxPending)
+      {
+        _atxPending->perform(renderer);
+        if (_atxPending->tex.tex)
+        {
+          if (_atx && _atx->tex.tex)
+            SDL_DestroyTexture(_atx->tex.tex);
+          _atx = _atxPending;
+          _atxPending.reset();
+        }
+      }
+
+      if (_atx)
+        SDL_RenderCopy(renderer, _atx->tex, ap);
     }
 
+    drawLabels(renderer, ap);
+}
+
+void Graph::drawLabels(SDL_Renderer *renderer, const Vector2i &ap)
+{
     if (_captionTex.dirty)
       mTheme->getTexAndRectUtf8(renderer, _captionTex, 0, 0, mCaption.c_str(), "sans", 14, mTextColor);
 
@@ -139,6 +468,6 @@ void Graph::draw(SDL_Renderer *renderer)
     SDL_RenderCopy(renderer, _captionTex, ap + Vector2i(3,1) );
     SDL_RenderCopy(renderer, _headerTex, ap + Vector2i(mSize.x - 3 - _headerTex.w(), 1));
     SDL_RenderCopy(renderer, _footerTex, ap + Vector2i(mSize.x - 3 - _footerTex.w(), mSize.y - 1 - _footerTex.h()));
- }
+}
 
 NAMESPACE_END(sdlgui)
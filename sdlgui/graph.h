@@ -18,6 +18,14 @@ NAMESPACE_BEGIN(sdlgui)
 class  Graph : public Widget 
 {
 public:
+    /// How \ref values is reduced before rasterization when it has more samples than pixel columns
+    enum class Decimation
+    {
+        None,   ///< One vertex per sample
+        MinMax, ///< Min/max envelope per pixel column, keeps every spike
+        LTTB    ///< Largest-Triangle-Three-Buckets, keeps the visual shape with fewer vertices
+    };
+
     Graph(Widget *parent, const std::string &caption = "Untitled");
 
     const std::string &caption() const { return mCaption; }
@@ -39,8 +47,27 @@ public:
     void setTextColor(const Color &textColor) { mTextColor = textColor; }
 
     const  std::vector<float>  &values() const { return mValues; }
-    std::vector<float>  &values() { return mValues; }
-    void setValues(const  std::vector<float>  &values) { mValues = values; }
+    /// Mutable access marks the plot for re-rasterization on the next frame
+    std::vector<float>  &values() { mValuesDirty = true; return mValues; }
+    void setValues(const  std::vector<float>  &values) { mValues = values; mValuesDirty = true; }
+
+    Decimation decimation() const { return mDecimation; }
+    void setDecimation(Decimation decimation) { mDecimation = decimation; mValuesDirty = true; }
+
+    /**
+     * \brief Switch the graph to streaming mode.
+     *
+     * Samples handed to \ref push go through a lock free ring buffer of
+     * \c capacity entries. Every frame the UI thread drains it and folds each
+     * \c samplesPerColumn samples into one pixel column (min/max envelope).
+     * The plot scrolls left by one pixel per column, and only the new columns
+     * are rasterized and uploaded. \ref values is not used in this mode.
+     */
+    void setStreaming(size_t capacity, int samplesPerColumn = 1);
+    bool streaming() const { return mStream != nullptr; }
+
+    /// Append a sample in [0, 1]; lock free, may be called from any thread in streaming mode
+    void push(float value);
 
     Vector2i preferredSize(SDL_Renderer *ctx) const override;
     void draw(SDL_Renderer *ctx) override;
@@ -49,6 +76,12 @@ protected:
     std::string mCaption, mHeader, mFooter;
     Color mBackgroundColor, mForegroundColor, mTextColor;
     std::vector<float>  mValues;
+    bool mValuesDirty = true;
+    Decimation mDecimation = Decimation::MinMax;
+
+    /* Decimated polyline: x in [0, 1] across the widget, y is the sample value */
+    std::vector<Vector2f> mPlot;
+    int mPlotWidth = -1;
 
     Texture _captionTex;
     Texture _headerTex;
@@ -56,7 +89,20 @@ protected:
 
     struct AsyncTexture;
     typedef std::shared_ptr<AsyncTexture> AsyncTexturePtr;
-    AsyncTexturePtr _atx;
+    AsyncTexturePtr _atx, _atxPending;
+
+    struct Stream;
+    std::shared_ptr<Stream> mStream;
+
+    void drawStream(SDL_Renderer *renderer, const Vector2i &ap);
+    /// Caption, header and footer text on top of the plot area
+    void drawLabels(SDL_Renderer *renderer, const Vector2i &ap);
+
+    /// Polyline for the current values and width, recomputed only when either changes
+    const std::vector<Vector2f> &plotPoints();
+
+    static void decimateMinMax(const float *values, size_t count, int columns, std::vector<Vector2f> &out);
+    static void decimateLTTB(const float *values, size_t count, size_t threshold, std::vector<Vector2f> &out);
 };
 
 NAMESPACE_END(sdlgui)
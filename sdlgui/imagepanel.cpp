@@ -20,6 +20,13 @@ ImagePanel::ImagePanel(Widget *parent)
 {
 }
 
+void ImagePanel::setImageLoader(const std::shared_ptr<ImageDirectoryLoader> &loader)
+{
+    mLoader = loader;
+    mResident.clear();
+    mImages = loader ? loader->images() : ListImages();
+}
+
 Vector2i ImagePanel::gridSize() const
 {
     int nCols = 1 + std::max(0,
@@ -37,8 +44,45 @@ int ImagePanel::indexForPosition(const Vector2i &p) const
                     pp.y - std::floor(pp.y) < iconRegion;
     Vector2i gridPos = pp.toint();
     Vector2i grid = gridSize();
-    overImage &= gridPos.positive() && gridPos.lessOrEq(grid);
-    return overImage ? (gridPos.x + gridPos.y * grid.x) : -1;
+    overImage &= gridPos.positive() && gridPos.x < grid.x && gridPos.y < grid.y;
+    int index = gridPos.x + gridPos.y * grid.x;
+    return overImage && index < (int)mImages.size() ? index : -1;
+}
+
+void ImagePanel::visibleRange(const Vector2i &grid, int &first, int &last) const
+{
+    PntRect clip = getAbsoluteCliprect();
+    int pitch = mThumbSize + mSpacing;
+    int top = clip.y1 - getAbsoluteTop() - mMargin;
+    int bottom = clip.y2 - getAbsoluteTop() - mMargin;
+
+    int firstRow = std::max(0, top / pitch);
+    int lastRow = std::min(grid.y, bottom / pitch + 1);
+    first = std::min((int)mImages.size(), firstRow * grid.x);
+    last = std::max(first, std::min((int)mImages.size(), lastRow * grid.x));
+}
+
+void ImagePanel::updateResidency(int first, int last, int columns)
+{
+    int keepFirst = std::max(0, first - mKeepRows * columns);
+    int keepLast = std::min((int)mImages.size(), last + mKeepRows * columns);
+
+    /* Release what scrolled out of the kept band, then request the visible entries */
+    size_t n = 0;
+    for (int i : mResident)
+    {
+        if (i >= keepFirst && i < keepLast)
+            mResident[n++] = i;
+        else
+        {
+            mLoader->release(i);
+            mImages[i] = mLoader->images()[i];
+        }
+    }
+    mResident.resize(n);
+
+    for (int i = first; i < last; i++)
+        mLoader->request(i);
 }
 
 bool ImagePanel::mouseMotionEvent(const Vector2i &p, const Vector2i & /* rel */,
@@ -69,6 +113,23 @@ Vector2i ImagePanel::preferredSize(SDL_Renderer *) const
 void ImagePanel::draw(SDL_Renderer* renderer) 
 {
   Vector2i grid = gridSize();
+    int first, last;
+    visibleRange(grid, first, last);
+
+    if (mLoader)
+    {
+        if (mLoader->onDemand())
+            updateResidency(first, last, grid.x);
+
+        mUpdated.clear();
+        mLoader->upload(renderer, mUploadsPerFrame, &mUpdated);
+        for (int i : mUpdated)
+        {
+            mImages[i] = mLoader->images()[i];
+            if (mLoader->onDemand())
+                mResident.push_back(i);
+        }
+    }
 
     int ax = getAbsoluteLeft();
     int ay = getAbsoluteTop();
@@ -76,7 +137,7 @@ void ImagePanel::draw(SDL_Renderer* renderer)
     PntRect clip = getAbsoluteCliprect();
     SDL_Rect clipRect = pntrect2srect(clip);
 
-    for (size_t i=0; i<mImages.size(); ++i) 
+    for (size_t i = first; i < (size_t)last; ++i) 
     {
       Vector2i p = Vector2i(mMargin, mMargin) + Vector2i((int) i % grid.x, (int) i / grid.x) * (mThumbSize + mSpacing);
         p += Vector2i(ax, ay);
@@ -133,7 +194,8 @@ void ImagePanel::draw(SDL_Renderer* renderer)
           imgSrcRect.h = (imgPaintRect.h / (float)ih) * imgh;
         }
 
-        SDL_RenderCopy(renderer, mImages[i].tex, &imgSrcRect, &imgPaintRect);
+        if (mImages[i].tex)
+          SDL_RenderCopy(renderer, mImages[i].tex, &imgSrcRect, &imgPaintRect);
 
         SDL_Rect brect{ p.x + 1, p.y + 1, mThumbSize - 2, mThumbSize - 2};
         brect = clip_rects(brect, clipRect);
@@ -28,9 +28,24 @@ public:
     ImagePanel(Widget *parent, const ListImages &data)
       : ImagePanel(parent) { setImages(data); }
 
-    void setImages(const ListImages &data) { mImages = data; }
+    void setImages(const ListImages &data) { mImages = data; mLoader.reset(); mResident.clear(); }
     const ListImages& images() const { return mImages; }
 
+    /**
+     * Show the entries of an asynchronous loader. Each entry is drawn as a
+     * placeholder until its thumbnail arrives. At most \ref uploadsPerFrame
+     * thumbnails are uploaded per frame.
+     */
+    void setImageLoader(const std::shared_ptr<ImageDirectoryLoader> &loader);
+    const std::shared_ptr<ImageDirectoryLoader> &imageLoader() const { return mLoader; }
+
+    int uploadsPerFrame() const { return mUploadsPerFrame; }
+    void setUploadsPerFrame(int uploads) { mUploadsPerFrame = uploads; }
+
+    /// Rows kept resident above and below the visible ones when the loader works on demand
+    int keepRows() const { return mKeepRows; }
+    void setKeepRows(int rows) { mKeepRows = rows; }
+
     std::function<void(int)> callback() const { return mCallback; }
     void setCallback(const std::function<void(int)> &callback) { mCallback = callback; }
 
@@ -40,11 +55,20 @@ public:
     void draw(SDL_Renderer* renderer) override;
 
     ImagePanel& withImages(const ListImages& data ) { setImages(data); return *this; }
+    ImagePanel& withImageLoader(const std::shared_ptr<ImageDirectoryLoader> &loader) { setImageLoader(loader); return *this; }
 protected:
   Vector2i gridSize() const;
     int indexForPosition(const Vector2i &p) const;
+    /// Range [first, last) of entries whose rows intersect the clip rect
+    void visibleRange(const Vector2i &grid, int &first, int &last) const;
+    void updateResidency(int first, int last, int columns);
 protected:
   ListImages mImages;
+    std::shared_ptr<ImageDirectoryLoader> mLoader;
+    std::vector<int> mUpdated;
+    std::vector<int> mResident;
+    int mUploadsPerFrame = 8;
+    int mKeepRows = 2;
     std::function<void(int)> mCallback;
     int mThumbSize;
     int mSpacing;
@@ -20,6 +20,9 @@
 #endif
 #include <sdlgui/theme.h>
 #include <cmath>
+#include <atomic>
+#include <list>
+#include <unordered_map>
 
 NAMESPACE_BEGIN(sdlgui)
 
@@ -40,6 +43,361 @@ namespace
     }
 }
 
+/* Mip pyramid of a CPU image; the worker only ever holds this part */
+struct MipPyramid
+{
+    struct Level
+    {
+        int w, h;
+        std::vector<uint32_t> pixels;
+    };
+
+    std::vector<Level> levels;
+    std::atomic<int> ready{ 0 };
+
+    /* 2x2 box filter per ARGB channel, edge samples clamped for odd sizes */
+    static void downsample(const Level& src, Level& dst)
+    {
+        dst.pixels.resize(size_t(dst.w) * dst.h);
+        for (int y = 0; y < dst.h; y++)
+        {
+            const uint32_t* r0 = src.pixels.data() + size_t(std::min(y * 2, src.h - 1)) * src.w;
+            const uint32_t* r1 = src.pixels.data() + size_t(std::min(y * 2 + 1, src.h - 1)) * src.w;
+            uint32_t* out = dst.pixels.data() + size_t(y) * dst.w;
+            for (int x = 0; x < dst.w; x++)
+            {
+                int x0 = std::min(x * 2, src.w - 1), x1 = std::min(x * 2 + 1, src.w - 1);
+                uint32_t a = r0[x0], b = r0[x1], c = r1[x0], d = r1[x1];
+                uint32_t p = 0;
+                for (int shift = 0; shift < 32; shift += 8)
+                {
+                    uint32_t sum = ((a >> shift) & 0xff) + ((b >> shift) & 0xff)
+                                 + ((c >> shift) & 0xff) + ((d >> shift) & 0xff);
+                    p |= ((sum + 2) >> 2) << shift;
+                }
+                out[x] = p;
+            }
+        }
+    }
+};
+
+struct ImageView::TiledImage
+{
+    static const int TileSize = 256;
+
+    struct Tile
+    {
+        uint64_t key;
+        SDL_Texture* tex;
+        uint64_t frame;
+    };
+
+    std::shared_ptr<MipPyramid> pyramid;
+    std::list<Tile> lru; // most recently drawn first
+    std::unordered_map<uint64_t, std::list<Tile>::iterator> index;
+    uint64_t frame = 0;
+    int uploads = 0;
+
+    ~TiledImage()
+    {
+        for (Tile& t : lru)
+            SDL_DestroyTexture(t.tex);
+    }
+
+    static uint64_t key(int level, int tx, int ty)
+    {
+        return (uint64_t(level) << 56) | (uint64_t(ty) << 28) | uint64_t(tx);
+    }
+
+    void load(SDL_Surface* image)
+    {
+        pyramid = std::make_shared<MipPyramid>();
+        SDL_Surface* argb = SDL_ConvertSurfaceFormat(image, SDL_PIXELFORMAT_ARGB8888, 0);
+        if (!argb)
+            return;
+
+        /* Reserve every level up front so the worker never reallocates what the UI thread reads */
+        int w = argb->w, h = argb->h;
+        pyramid->levels.push_back({ w, h, {} });
+        while (w > TileSize || h > TileSize)
+        {
+            w = std::max(1, (w + 1) / 2);
+            h = std::max(1, (h + 1) / 2);
+            pyramid->levels.push_back({ w, h, {} });
+        }
+
+        MipPyramid::Level& base = pyramid->levels[0];
+        base.pixels.resize(size_t(base.w) * base.h);
+        SDL_LockSurface(argb);
+        for (int y = 0; y < base.h; y++)
+            memcpy(base.pixels.data() + size_t(y) * base.w, (uint8_t*)argb->pixels + y * argb->pitch, base.w * sizeof(uint32_t));
+        SDL_UnlockSurface(argb);
+        SDL_FreeSurface(argb);
+        pyramid->ready.store(1, std::memory_order_release);
+
+        std::shared_ptr<MipPyramid> target = pyramid;
+        runAsync([target]() {
+            for (size_t k = 1; k < target->levels.size(); k++)
+            {
+                MipPyramid::downsample(target->levels[k - 1], target->levels[k]);
+                target->ready.store(int(k + 1), std::memory_order_release);
+            }
+        });
+    }
+
+    /* Resident tile texture, uploaded on demand while the frame budget lasts */
+    SDL_Texture* tile(SDL_Renderer* renderer, int level, int tx, int ty, bool upload)
+    {
+        uint64_t k = key(level, tx, ty);
+        auto it = index.find(k);
+        if (it != index.end())
+        {
+            it->second->frame = frame;
+            lru.splice(lru.begin(), lru, it->second);
+            return it->second->tex;
+        }
+        if (!upload || uploads <= 0)
+            return nullptr;
+
+        const MipPyramid::Level& l = pyramid->levels[level];
+        int x0 = tx * TileSize, y0 = ty * TileSize;
+        int tw = std::min(TileSize, l.w - x0), th = std::min(TileSize, l.h - y0);
+        SDL_Texture* tex = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, tw, th);
+        if (!tex)
+            return nullptr;
+        SDL_SetTextureBlendMode(tex, SDL_BLENDMODE_BLEND);
+        SDL_UpdateTexture(tex, nullptr, l.pixels.data() + size_t(y0) * l.w + x0, l.w * sizeof(uint32_t));
+        uploads--;
+
+        lru.push_front({ k, tex, frame });
+        index[k] = lru.begin();
+        return tex;
+    }
+
+    /* Drop least recently drawn tiles, never the ones used this frame */
+    void trim(size_t capacity)
+    {
+        while (lru.size() > capacity && lru.back().frame != frame)
+        {
+            SDL_DestroyTexture(lru.back().tex);
+            index.erase(lru.back().key);
+            lru.pop_back();
+        }
+    }
+};
+
+/* Float or 16-bit source kept at full precision, processed for the visible part of the widget only */
+struct ImageView::ProcessedImage
+{
+  static const int LutSize = 4096;
+
+  int w = 0, h = 0, channels = 0;
+  std::vector<float> f32;
+  std::vector<uint16_t> u16;
+
+  /* View the buffers below were produced for. Whole pixel pans are kept apart
+     from the offset so shifted and freshly processed pixels sample identically */
+  int viewW = 0, viewH = 0;
+  Vector2f offset;
+  int panX = 0, panY = 0;
+  float scale = 0.f;
+  Filter filter = Filter::Nearest;
+  float exposure = 0.f, gamma = 0.f;
+  Channel channel = Channel::RGB;
+  bool valid = false;
+
+  std::vector<float> linear;    // resampled RGBA per widget pixel
+  std::vector<uint32_t> pixels; // ARGB8888 after exposure, gamma and channel
+  std::vector<uint8_t> lut;     // gamma curve over [0, 1]
+  float lutGamma = 0.f;
+  SDL_Texture* texture = nullptr;
+
+  struct Column
+  {
+    int x0, x1;
+    float t;
+  };
+  std::vector<Column> columns;
+
+  ~ProcessedImage()
+  {
+    if (texture)
+      SDL_DestroyTexture(texture);
+  }
+
+  template <typename T>
+  void load(const T* src, int width, int height, int n, std::vector<T>& dst)
+  {
+    w = width;
+    h = height;
+    channels = std::min(std::max(n, 1), 4);
+    dst.assign(src, src + size_t(w) * h * channels);
+  }
+
+  /* Widget pixels whose centers fall on the image */
+  SDL_Rect coverage() const
+  {
+    auto span = [](float origin, int pan, float length, int limit, int& a, int& b) {
+      a = std::min(std::max((int)std::ceil(origin - 0.5f) + pan, 0), limit);
+      b = std::min(std::max((int)std::ceil(origin + length - 0.5f) + pan, 0), limit);
+    };
+    int x0, x1, y0, y1;
+    span(offset.x, panX, w * scale, viewW, x0, x1);
+    span(offset.y, panY, h * scale, viewH, y0, y1);
+    return SDL_Rect{ x0, y0, std::max(x1 - x0, 0), std::max(y1 - y0, 0) };
+  }
+
+  /* Source index pair and weight for a widget coordinate along one axis */
+  Column sample(int p, float origin, int limit) const
+  {
+    float f = (p + 0.5f - origin) / scale;
+    if (filter == Filter::Bilinear)
+      f -= 0.5f;
+    int i = (int)std::floor(f);
+    Column c;
+    c.x0 = std::min(std::max(i, 0), limit - 1);
+    c.x1 = filter == Filter::Bilinear ? std::min(std::max(i + 1, 0), limit - 1) : c.x0;
+    c.t = filter == Filter::Bilinear ? f - i : 0.f;
+    return c;
+  }
+
+  template <typename T>
+  void resample(const T* src, float norm, const SDL_Rect& r)
+  {
+    const int n = channels;
+    auto fetch = [n, norm](const T* p, float* v) {
+      if (n >= 3)
+      {
+        v[0] = p[0] * norm; v[1] = p[1] * norm; v[2] = p[2] * norm;
+        v[3] = n == 4 ? p[3] * norm : 1.f;
+      }
+      else
+      {
+        v[0] = v[1] = v[2] = p[0] * norm;
+        v[3] = n == 2 ? p[1] * norm : 1.f;
+      }
+    };
+
+    /* Source columns and weights are shared by every row of the rect */
+    columns.resize(r.w);
+    for (int i = 0; i < r.w; i++)
+      columns[i] = sample(r.x + i - panX, offset.x, w);
+
+    size_t stride = size_t(w) * n;
+    for (int y = r.y; y < r.y + r.h; y++)
+    {
+      Column row = sample(y - panY, offset.y, h);
+      const T* r0 = src + row.x0 * stride;
+      const T* r1 = src + row.x1 * stride;
+      float* out = linear.data() + (size_t(y) * viewW + r.x) * 4;
+
+      if (filter == Filter::Nearest)
+      {
+        for (int i = 0; i < r.w; i++, out += 4)
+          fetch(r0 + columns[i].x0 * n, out);
+        continue;
+      }
+
+      for (int i = 0; i < r.w; i++, out += 4)
+      {
+        const Column& c = columns[i];
+        float a[4], b[4], d[4], e[4];
+        fetch(r0 + c.x0 * n, a);
+        fetch(r0 + c.x1 * n, b);
+        fetch(r1 + c.x0 * n, d);
+        fetch(r1 + c.x1 * n, e);
+        for (int k = 0; k < 4; k++)
+        {
+          float top = a[k] + (b[k] - a[k]) * c.t;
+          float bottom = d[k] + (e[k] - d[k]) * c.t;
+          out[k] = top + (bottom - top) * row.t;
+        }
+      }
+    }
+  }
+
+  void resample(const SDL_Rect& r)
+  {
+    SDL_Rect c = coverage(), area;
+    if (!SDL_IntersectRect(&r, &c, &area))
+      return;
+    if (!f32.empty())
+      resample(f32.data(), 1.f, area);
+    else
+      resample(u16.data(), 1.f / 65535.f, area);
+  }
+
+  /* Exposure, gamma and channel selection into 8-bit pixels; pixels off the image stay transparent */
+  void tone(const SDL_Rect& r)
+  {
+    if (lutGamma != gamma)
+    {
+      lut.resize(LutSize);
+      for (int i = 0; i < LutSize; i++)
+        lut[i] = (uint8_t)std::lround(255.f * std::pow(i / float(LutSize - 1), 1.f / gamma));
+      lutGamma = gamma;
+    }
+
+    const float gain = std::exp2(exposure) * (LutSize - 1);
+    auto curve = [&](float v) -> uint32_t {
+      v *= gain;
+      return lut[!(v > 0.f) ? 0 : v >= LutSize - 1 ? LutSize - 1 : int(v + 0.5f)];
+    };
+    auto linearByte = [](float v) -> uint32_t {
+      return !(v > 0.f) ? 0 : v >= 1.f ? 255 : uint32_t(v * 255.f + 0.5f);
+    };
+
+    SDL_Rect c = coverage();
+    for (int y = r.y; y < r.y + r.h; y++)
+    {
+      uint32_t* out = pixels.data() + size_t(y) * viewW;
+      bool rowCovered = y >= c.y && y < c.y + c.h;
+      int x0 = rowCovered ? std::max(r.x, c.x) : r.x + r.w;
+      int x1 = rowCovered ? std::min(r.x + r.w, c.x + c.w) : r.x + r.w;
+      x0 = std::min(x0, r.x + r.w);
+      x1 = std::max(x1, x0);
+
+      std::fill(out + r.x, out + x0, 0u);
+      std::fill(out + x1, out + r.x + r.w, 0u);
+
+      const float* v = linear.data() + (size_t(y) * viewW + x0) * 4;
+      switch (channel)
+      {
+      case Channel::RGB:
+        for (int x = x0; x < x1; x++, v += 4)
+          out[x] = (linearByte(v[3]) << 24) | (curve(v[0]) << 16) | (curve(v[1]) << 8) | curve(v[2]);
+        break;
+      case Channel::Alpha:
+        for (int x = x0; x < x1; x++, v += 4)
+          out[x] = 0xff000000u | (linearByte(v[3]) * 0x010101u);
+        break;
+      default:
+      {
+        int k = channel == Channel::Red ? 0 : channel == Channel::Green ? 1 : 2;
+        for (int x = x0; x < x1; x++, v += 4)
+          out[x] = 0xff000000u | (curve(v[k]) * 0x010101u);
+        break;
+      }
+      }
+    }
+  }
+
+  /* Moves the cached view by whole pixels; the vacated strips are left for the caller to refill */
+  template <typename T>
+  static void shift(std::vector<T>& buf, int bw, int bh, int n, int dx, int dy)
+  {
+    size_t row = size_t(bw) * n;
+    int rows = bh - std::abs(dy), cols = bw - std::abs(dx);
+    for (int i = 0; i < rows; i++)
+    {
+      int y = dy > 0 ? bh - 1 - i : i;
+      const T* s = buf.data() + size_t(y - dy) * row + size_t(std::max(0, -dx)) * n;
+      T* d = buf.data() + size_t(y) * row + size_t(std::max(0, dx)) * n;
+      memmove(d, s, size_t(cols) * n * sizeof(T));
+    }
+  }
+};
+
 ImageView::ImageView(Widget* parent, SDL_Texture* texture)
     : Widget(parent), mTexture(texture), mScale(1.0f), mOffset(Vector2f::Zero()),
     mFixedScale(false), mFixedOffset(false), mPixelInfoCallback(nullptr) 
@@ -47,11 +405,54 @@ ImageView::ImageView(Widget* parent, SDL_Texture* texture)
     updateImageParameters();
 }
 
+ImageView::ImageView(Widget* parent, SDL_Surface* image)
+    : Widget(parent), mScale(1.0f), mOffset(Vector2f::Zero()),
+    mFixedScale(false), mFixedOffset(false), mPixelInfoCallback(nullptr) 
+{
+    bindImage(image);
+}
+
 ImageView::~ImageView() {}
 
 void ImageView::bindImage(SDL_Texture* texture) 
 {
     mTexture = texture;
+    mTiled.reset();
+    mProcessed.reset();
+    invalidatePixelInfo();
+    updateImageParameters();
+    fit();
+}
+
+void ImageView::bindImage(SDL_Surface* image)
+{
+    mTexture = nullptr;
+    mProcessed.reset();
+    mTiled = std::make_shared<TiledImage>();
+    mTiled->load(image);
+    invalidatePixelInfo();
+    updateImageParameters();
+    fit();
+}
+
+void ImageView::bindImage(const float* pixels, int width, int height, int channels)
+{
+    mTexture = nullptr;
+    mTiled.reset();
+    mProcessed = std::make_shared<ProcessedImage>();
+    mProcessed->load(pixels, width, height, channels, mProcessed->f32);
+    invalidatePixelInfo();
+    updateImageParameters();
+    fit();
+}
+
+void ImageView::bindImage(const uint16_t* pixels, int width, int height, int channels)
+{
+    mTexture = nullptr;
+    mTiled.reset();
+    mProcessed = std::make_shared<ProcessedImage>();
+    mProcessed->load(pixels, width, height, channels, mProcessed->u16);
+    invalidatePixelInfo();
     updateImageParameters();
     fit();
 }
@@ -261,7 +662,8 @@ void ImageView::draw(SDL_Renderer* renderer)
 
     SDL_Point ap = getAbsolutePos();
 
-    const Screen* screen = dynamic_cast<const Screen*>(this->window()->parent());
+    const Widget* top = this->window()->parent();
+    const Screen* screen = top && top->isKind(KindScreen) ? static_cast<const Screen*>(top) : nullptr;
     assert(screen);
     Vector2f screenSize = screen->size().tofloat();
     Vector2f scaleFactor = imageSizeF().cquotient(screenSize) * mScale;
@@ -309,6 +711,14 @@ void ImageView::draw(SDL_Renderer* renderer)
 
       SDL_RenderCopy(renderer, mTexture, &imgrect, &rect);
     }
+    else if (mTiled)
+    {
+      drawTiles(renderer, ap);
+    }
+    else if (mProcessed)
+    {
+      drawProcessed(renderer, ap);
+    }
 
     drawWidgetBorder(renderer, ap);
     drawImageBorder(renderer, ap);
@@ -320,11 +730,185 @@ void ImageView::draw(SDL_Renderer* renderer)
 
 void ImageView::updateImageParameters() 
 {
-  int w, h;
-  SDL_QueryTexture(mTexture, nullptr, nullptr, &w, &h);
+  int w = 0, h = 0;
+  if (mTiled && !mTiled->pyramid->levels.empty())
+  {
+    w = mTiled->pyramid->levels[0].w;
+    h = mTiled->pyramid->levels[0].h;
+  }
+  else if (mProcessed)
+  {
+    w = mProcessed->w;
+    h = mProcessed->h;
+  }
+  else if (mTexture)
+    SDL_QueryTexture(mTexture, nullptr, nullptr, &w, &h);
   mImageSize = Vector2i(w, h);
 }
 
+void ImageView::drawTiles(SDL_Renderer* renderer, const SDL_Point& ap)
+{
+  TiledImage& t = *mTiled;
+  const MipPyramid& pyramid = *t.pyramid;
+  int ready = pyramid.ready.load(std::memory_order_acquire);
+  if (ready == 0)
+    return;
+
+  t.frame++;
+  t.uploads = mTileUploadsPerFrame;
+
+  /* Finest level that is not sampled below one texel per pixel, or the finest built so far */
+  int level = 0;
+  if (mScale > 0.f && mScale < 1.f)
+    level = std::min((int)std::floor(std::log2(1.f / mScale)), ready - 1);
+
+  /* The single tile of the coarsest level stays resident as the fallback of last resort */
+  if (ready == (int)pyramid.levels.size() && level < ready - 1)
+    t.tile(renderer, ready - 1, 0, 0, true);
+
+  /* Visible image rect, in level 0 pixels */
+  Vector2f first = clampedImageCoordinateAt({ 0, 0 });
+  Vector2f last = clampedImageCoordinateAt(sizeF());
+  if (last.x <= first.x || last.y <= first.y)
+    return;
+
+  bool hadClip = SDL_RenderIsClipEnabled(renderer) == SDL_TRUE;
+  SDL_Rect oldClip{ 0, 0, 0, 0 };
+  if (hadClip)
+    SDL_RenderGetClipRect(renderer, &oldClip);
+  SDL_Rect clip{ ap.x, ap.y, mSize.x, mSize.y };
+  if (hadClip && !SDL_IntersectRect(&clip, &oldClip, &clip))
+    clip = SDL_Rect{ ap.x, ap.y, 0, 0 };
+  SDL_RenderSetClipRect(renderer, &clip);
+
+  /* Image rect in level 0 pixels to screen, rounded at both edges so tiles never leave seams */
+  auto toScreen = [&](float ix0, float iy0, float ix1, float iy1) {
+    int x0 = (int)std::round(ap.x + mOffset.x + ix0 * mScale);
+    int y0 = (int)std::round(ap.y + mOffset.y + iy0 * mScale);
+    int x1 = (int)std::round(ap.x + mOffset.x + ix1 * mScale);
+    int y1 = (int)std::round(ap.y + mOffset.y + iy1 * mScale);
+    return SDL_Rect{ x0, y0, x1 - x0, y1 - y0 };
+  };
+
+  const int T = TiledImage::TileSize;
+  int span = T << level;
+  int tx0 = (int)first.x / span, tx1 = ((int)std::ceil(last.x) - 1) / span;
+  int ty0 = (int)first.y / span, ty1 = ((int)std::ceil(last.y) - 1) / span;
+
+  for (int ty = ty0; ty <= ty1; ty++)
+    for (int tx = tx0; tx <= tx1; tx++)
+    {
+      const MipPyramid::Level& l = pyramid.levels[level];
+      int tw = std::min(T, l.w - tx * T), th = std::min(T, l.h - ty * T);
+      SDL_Rect dst = toScreen(float(tx * span), float(ty * span), float(tx * span + (tw << level)), float(ty * span + (th << level)));
+
+      if (SDL_Texture* tex = t.tile(renderer, level, tx, ty, true))
+      {
+        SDL_RenderCopy(renderer, tex, nullptr, &dst);
+        continue;
+      }
+
+      /* Not uploaded yet: show the matching part of a resident coarser tile */
+      for (int up = level + 1; up < ready; up++)
+      {
+        int shift = up - level;
+        int ptx = tx >> shift, pty = ty >> shift;
+        SDL_Texture* tex = t.tile(renderer, up, ptx, pty, false);
+        if (!tex)
+          continue;
+        int sub = T >> shift;
+        SDL_Rect src{ (tx - (ptx << shift)) * sub, (ty - (pty << shift)) * sub,
+                      std::max(1, (tw + (1 << shift) - 1) >> shift), std::max(1, (th + (1 << shift) - 1) >> shift) };
+        SDL_RenderCopy(renderer, tex, &src, &dst);
+        break;
+      }
+    }
+
+  SDL_RenderSetClipRect(renderer, hadClip ? &oldClip : nullptr);
+  t.trim(std::max(mTileCacheSize, 1));
+}
+
+void ImageView::drawProcessed(SDL_Renderer* renderer, const SDL_Point& ap)
+{
+  ProcessedImage& p = *mProcessed;
+  int ww = width(), hh = height();
+  if (ww <= 0 || hh <= 0 || p.w <= 0 || p.h <= 0)
+    return;
+
+  bool resample = !p.valid || p.scale != mScale || p.filter != mFilter;
+  if (!p.texture || p.viewW != ww || p.viewH != hh)
+  {
+    if (p.texture)
+      SDL_DestroyTexture(p.texture);
+    p.texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, ww, hh);
+    if (!p.texture)
+      return;
+    SDL_SetTextureBlendMode(p.texture, SDL_BLENDMODE_BLEND);
+    p.viewW = ww;
+    p.viewH = hh;
+    p.linear.assign(size_t(ww) * hh * 4, 0.f);
+    p.pixels.assign(size_t(ww) * hh, 0u);
+    resample = true;
+  }
+
+  SDL_Rect view{ 0, 0, ww, hh };
+  bool retone = p.exposure != mExposure || p.gamma != mGamma || p.channel != mChannel;
+  p.exposure = mExposure;
+  p.gamma = mGamma;
+  p.channel = mChannel;
+  p.filter = mFilter;
+  p.scale = mScale;
+
+  bool changed = true;
+  Vector2f delta = mOffset - p.offset;
+  int dx = (int)std::round(delta.x) - p.panX, dy = (int)std::round(delta.y) - p.panY;
+  bool wholePixels = std::abs(delta.x - dx - p.panX) < 1e-3f && std::abs(delta.y - dy - p.panY) < 1e-3f
+                     && std::abs(dx) < ww && std::abs(dy) < hh;
+
+  if (resample || !wholePixels)
+  {
+    p.offset = mOffset;
+    p.panX = p.panY = 0;
+    p.resample(view);
+    p.tone(view);
+  }
+  else if (dx != 0 || dy != 0)
+  {
+    /* Panning: keep what is still in view and only process the exposed strips */
+    p.panX += dx;
+    p.panY += dy;
+    ProcessedImage::shift(p.linear, ww, hh, 4, dx, dy);
+    ProcessedImage::shift(p.pixels, ww, hh, 1, dx, dy);
+    SDL_Rect strips[2] = {
+      SDL_Rect{ dx > 0 ? 0 : ww + dx, 0, std::abs(dx), hh },
+      SDL_Rect{ 0, dy > 0 ? 0 : hh + dy, ww, std::abs(dy) } };
+    for (const SDL_Rect& r : strips)
+      if (r.w > 0 && r.h > 0)
+      {
+        p.resample(r);
+        if (!retone)
+          p.tone(r);
+      }
+    if (retone)
+      p.tone(view);
+  }
+  else if (retone)
+  {
+    p.tone(view);
+  }
+  else
+  {
+    changed = false;
+  }
+  p.valid = true;
+
+  if (changed)
+    SDL_UpdateTexture(p.texture, nullptr, p.pixels.data(), ww * sizeof(uint32_t));
+
+  SDL_Rect dst{ ap.x, ap.y, ww, hh };
+  SDL_RenderCopy(renderer, p.texture, nullptr, &dst);
+}
+
 void ImageView::drawWidgetBorder(SDL_Renderer* renderer, const SDL_Point& ap) const 
 {
   SDL_Color lc = mTheme->mBorderLight.toSdlColor();
@@ -364,52 +948,83 @@ void ImageView::drawImageBorder(SDL_Renderer* renderer, const SDL_Point& ap) con
   if (r.y2 < wr.y2) SDL_RenderDrawLine(renderer, r.x1, r.y2, r.x2-1, r.y2);
 }
 
-void ImageView::drawHelpers(SDL_Renderer* renderer) const 
+void ImageView::drawHelpers(SDL_Renderer* renderer) 
 {
-  Vector2f upperLeftCorner = positionForCoordinate(Vector2f{ 0, 0 }) + positionF();
-  Vector2f lowerRightCorner = positionForCoordinate(imageSizeF()) + positionF();
-    // Use the scissor method in NanoVG to display only the correct part of the grid.
-  Vector2f scissorPosition = upperLeftCorner.cmax(positionF());
-  Vector2f sizeOffsetDifference = sizeF() - mOffset;
-  Vector2f scissorSize = sizeOffsetDifference.cmin(sizeF());
+  Vector2f ap = absolutePosition().tofloat();
+  Vector2f upperLeftCorner = positionForCoordinate(Vector2f{ 0, 0 }) + ap;
+  Vector2f lowerRightCorner = positionForCoordinate(imageSizeF()) + ap;
+
+  /* Keep the overlays inside the widget, on top of any clip already set */
+  bool hadClip = SDL_RenderIsClipEnabled(renderer) == SDL_TRUE;
+  SDL_Rect oldClip{ 0, 0, 0, 0 };
+  if (hadClip)
+    SDL_RenderGetClipRect(renderer, &oldClip);
+  SDL_Rect clip{ (int)ap.x, (int)ap.y, mSize.x, mSize.y };
+  if (hadClip && !SDL_IntersectRect(&clip, &oldClip, &clip))
+    clip = SDL_Rect{ (int)ap.x, (int)ap.y, 0, 0 };
+  SDL_RenderSetClipRect(renderer, &clip);
 
-  SDL_Rect r{
-      (int)std::round(scissorPosition.x),
-      (int)std::round(scissorPosition.y),
-      (int)std::round(scissorSize.x),
-      (int)std::round(scissorSize.y)
-  };
   if (gridVisible())
-    drawPixelGrid(renderer, upperLeftCorner, lowerRightCorner, mScale);
+    drawPixelGrid(renderer, upperLeftCorner, lowerRightCorner, clip, mScale);
   if (pixelInfoVisible())
     drawPixelInfo(renderer, mScale);
+
+  SDL_RenderSetClipRect(renderer, hadClip ? &oldClip : nullptr);
 }
 
 void ImageView::drawPixelGrid(SDL_Renderer* renderer, const Vector2f& upperLeftCorner,
-                              const Vector2f& lowerRightCorner, const float stride) 
+                              const Vector2f& lowerRightCorner, const SDL_Rect& clip, const float stride) 
 {
+  if (clip.w <= 0 || clip.h <= 0)
+    return;
+
+  /* Grid lines that cross the clip rect, as one zig-zag polyline per direction. The joints
+     run along the image border or just outside the clip rect, so they never show */
+  float left = std::max(upperLeftCorner.x, float(clip.x - 1));
+  float right = std::min(lowerRightCorner.x, float(clip.x + clip.w));
+  float top = std::max(upperLeftCorner.y, float(clip.y - 1));
+  float bottom = std::min(lowerRightCorner.y, float(clip.y + clip.h));
+  if (right < left || bottom < top)
+    return;
+
+  int kx0 = std::max(0, (int)std::ceil((left - upperLeftCorner.x) / stride));
+  int kx1 = std::min(mImageSize.x, (int)std::floor((right - upperLeftCorner.x) / stride));
+  int ky0 = std::max(0, (int)std::ceil((top - upperLeftCorner.y) / stride));
+  int ky1 = std::min(mImageSize.y, (int)std::floor((bottom - upperLeftCorner.y) / stride));
+
   SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
 
-    // Draw the vertical lines for the grid
-    float currentX = std::floor(upperLeftCorner.x);
-    while (currentX <= lowerRightCorner.x) 
-    {
-      SDL_RenderDrawLine(renderer, std::floor(currentX), std::floor(upperLeftCorner.y),
-                          std::floor(currentX), std::floor(lowerRightCorner.y));
-      currentX += stride;
-    }
-    // Draw the horizontal lines for the grid.
-    float currentY = std::floor(upperLeftCorner.y);
-    while (currentY <= lowerRightCorner.y) 
-    {
-      SDL_RenderDrawLine(renderer, std::floor(upperLeftCorner.x), std::floor(currentY),
-                                    std::floor(lowerRightCorner.x), std::floor(currentY));
-      currentY += stride;
-    }
+  mGridPoints.clear();
+  bool down = true;
+  for (int k = kx0; k <= kx1; k++, down = !down)
+  {
+    int x = (int)std::floor(upperLeftCorner.x + k * stride);
+    mGridPoints.push_back(SDL_Point{ x, (int)std::floor(down ? top : bottom) });
+    mGridPoints.push_back(SDL_Point{ x, (int)std::floor(down ? bottom : top) });
+  }
+  if (mGridPoints.size() >= 2)
+    SDL_RenderDrawLines(renderer, mGridPoints.data(), (int)mGridPoints.size());
+
+  mGridPoints.clear();
+  bool across = true;
+  for (int k = ky0; k <= ky1; k++, across = !across)
+  {
+    int y = (int)std::floor(upperLeftCorner.y + k * stride);
+    mGridPoints.push_back(SDL_Point{ (int)std::floor(across ? left : right), y });
+    mGridPoints.push_back(SDL_Point{ (int)std::floor(across ? right : left), y });
+  }
+  if (mGridPoints.size() >= 2)
+    SDL_RenderDrawLines(renderer, mGridPoints.data(), (int)mGridPoints.size());
 }
 
-void ImageView::drawPixelInfo(SDL_Renderer* renderer, const float stride) const 
+void ImageView::drawPixelInfo(SDL_Renderer* renderer, const float stride) 
 {
+  /* One atlas at the largest overlay size, glyph quads are scaled down from it */
+  static constexpr float maxFontSize = 30.0f;
+  mGlyphAtlas = mTheme->getGlyphAtlas(renderer, "sans", (size_t)maxFontSize);
+  if (!mGlyphAtlas || !mGlyphAtlas->tex.tex)
+    return;
+
     // Extract the image coordinates at the two corners of the widget.
   Vector2f currentPixelF = clampedImageCoordinateAt({ 0,0 });
   Vector2f lastPixelF = clampedImageCoordinateAt(sizeF());
@@ -419,57 +1034,84 @@ void ImageView::drawPixelInfo(SDL_Renderer* renderer, const float stride) const
     lastPixelF = lastPixelF.ceil();
     Vector2i currentPixel = currentPixelF.cast<int>();
     Vector2i lastPixel = lastPixelF.cast<int>();
+    Vector2i extent = lastPixel - currentPixel;
+    if (extent.x <= 0 || extent.y <= 0)
+      return;
+
+    /* Carry over the cached strings that are still in view, the rest is fetched lazily */
+    if (currentPixel != mPixelInfoOrigin || extent != mPixelInfoExtent)
+    {
+      std::vector<PixelInfo> info(size_t(extent.x) * extent.y);
+      for (int y = 0; y < mPixelInfoExtent.y; y++)
+        for (int x = 0; x < mPixelInfoExtent.x; x++)
+        {
+          Vector2i p = mPixelInfoOrigin + Vector2i(x, y) - currentPixel;
+          if (p.x >= 0 && p.y >= 0 && p.x < extent.x && p.y < extent.y)
+            info[size_t(p.y) * extent.x + p.x] = std::move(mPixelInfo[size_t(y) * mPixelInfoExtent.x + x]);
+        }
+      mPixelInfo.swap(info);
+      mPixelInfoOrigin = currentPixel;
+      mPixelInfoExtent = extent;
+    }
 
     // Extract the positions for where to draw the text.
-    Vector2f currentCellPosition = (positionF() + positionForCoordinate(currentPixelF));
+    Vector2f currentCellPosition = (absolutePosition().tofloat() + positionForCoordinate(currentPixelF));
     float xInitialPosition = currentCellPosition.x;
     int xInitialIndex = currentPixel.x;
 
     // Properly scale the pixel information for the given stride.
     auto fontSize = stride * mFontScaleFactor;
-    static constexpr float maxFontSize = 30.0f;
     fontSize = fontSize > maxFontSize ? maxFontSize : fontSize;
 
-   /* nvgSave(ctx);
-    nvgBeginPath(ctx);
-    nvgFontSize(ctx, fontSize);
-    nvgTextAlign(ctx, NVG_ALIGN_CENTER | NVG_ALIGN_TOP);
-    nvgFontFace(ctx, "sans");
-    while (currentPixel.y() != lastPixel.y()) 
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    mGlyphVertices.clear();
+    mGlyphIndices.clear();
+#endif
+    while (currentPixel.y != lastPixel.y) 
     {
-        while (currentPixel.x() != lastPixel.x()) 
+        while (currentPixel.x != lastPixel.x) 
         {
-            writePixelInfo(ctx, currentCellPosition, currentPixel, stride);
-            currentCellPosition.x() += stride;
-            ++currentPixel.x();
+            writePixelInfo(*mGlyphAtlas, fontSize / maxFontSize, currentCellPosition, currentPixel, stride);
+            currentCellPosition.x += stride;
+            ++currentPixel.x;
         }
-        currentCellPosition.x() = xInitialPosition;
-        currentCellPosition.y() += stride;
-        ++currentPixel.y();
-        currentPixel.x() = xInitialIndex;
+        currentCellPosition.x = xInitialPosition;
+        currentCellPosition.y += stride;
+        ++currentPixel.y;
+        currentPixel.x = xInitialIndex;
     }
-    nvgRestore(ctx);*/
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    if (!mGlyphIndices.empty())
+      SDL_RenderGeometry(renderer, mGlyphAtlas->tex.tex, mGlyphVertices.data(), (int)mGlyphVertices.size(),
+                         mGlyphIndices.data(), (int)mGlyphIndices.size());
+#else
+    (void)renderer;
+#endif
 }
 
-void ImageView::writePixelInfo(SDL_Renderer* renderer, const Vector2f& cellPosition,
-                               const Vector2i& pixel, const float stride) const
+void ImageView::writePixelInfo(const GlyphAtlas& atlas, float fontScale, const Vector2f& cellPosition,
+                               const Vector2i& pixel, const float stride)
 {
- /*   auto pixelData = mPixelInfoCallback(pixel);
-    auto pixelDataRows = splitString(pixelData.first, "\n");
+    PixelInfo& info = mPixelInfo[size_t(pixel.y - mPixelInfoOrigin.y) * mPixelInfoExtent.x + (pixel.x - mPixelInfoOrigin.x)];
+    if (!info.valid)
+    {
+      auto pixelData = mPixelInfoCallback(pixel);
+      info.rows = splitString(pixelData.first, "\n");
+      info.color = pixelData.second.toSdlColor();
+      info.valid = true;
+    }
 
     // If no data is provided for this pixel then simply return.
-    if (pixelDataRows.empty())
+    if (info.rows.empty())
         return;
 
-    nvgFillColor(ctx, pixelData.second);
     auto padding = stride / 10;
     auto maxSize = stride - 2 * padding;
 
     // Measure the size of a single line of text.
-    float bounds[4];
-    nvgTextBoxBounds(ctx, 0.0f, 0.0f, maxSize, pixelDataRows.front().data(), nullptr, bounds);
-    auto rowHeight = bounds[3] - bounds[1];
-    auto totalRowsHeight = rowHeight * pixelDataRows.size();
+    float rowHeight = atlas.lineHeight * fontScale;
+    auto totalRowsHeight = rowHeight * info.rows.size();
 
     // Choose the initial y offset and the index for the past the last visible row.
     auto yOffset = 0.0f;
@@ -480,15 +1122,43 @@ void ImageView::writePixelInfo(SDL_Renderer* renderer, const Vector2f& cellPosit
         lastIndex = (int) (maxSize / rowHeight);
     } else {
         yOffset = (stride - totalRowsHeight) / 2;
-        lastIndex = (int) pixelDataRows.size();
+        lastIndex = (int) info.rows.size();
     }
 
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    float tw = (float)atlas.tex.w(), th = (float)atlas.tex.h();
     for (int i = 0; i != lastIndex; ++i) {
-        nvgText(ctx, cellPosition.x() + stride / 2, cellPosition.y() + yOffset,
-                pixelDataRows[i].data(), nullptr);
+        const std::string& row = info.rows[i];
+        float width = 0;
+        for (char c : row)
+            if (const SDL_Rect* g = atlas.glyph(c))
+                width += g->w * fontScale;
+
+        // Centered on the cell, like NVG_ALIGN_CENTER | NVG_ALIGN_TOP
+        float x = cellPosition.x + stride / 2 - width / 2;
+        float y = cellPosition.y + yOffset;
+        for (char c : row)
+        {
+            const SDL_Rect* g = atlas.glyph(c);
+            if (!g)
+                continue;
+            float w = g->w * fontScale, h = g->h * fontScale;
+            if (c != ' ')
+            {
+                int base = (int)mGlyphVertices.size();
+                float u0 = g->x / tw, u1 = (g->x + g->w) / tw, v1 = g->h / th;
+                mGlyphVertices.push_back(SDL_Vertex{ { x, y }, info.color, { u0, 0 } });
+                mGlyphVertices.push_back(SDL_Vertex{ { x + w, y }, info.color, { u1, 0 } });
+                mGlyphVertices.push_back(SDL_Vertex{ { x + w, y + h }, info.color, { u1, v1 } });
+                mGlyphVertices.push_back(SDL_Vertex{ { x, y + h }, info.color, { u0, v1 } });
+                int quad[6] = { base, base + 1, base + 2, base, base + 2, base + 3 };
+                mGlyphIndices.insert(mGlyphIndices.end(), quad, quad + 6);
+            }
+            x += w;
+        }
         yOffset += rowHeight;
     }
-*/
+#endif
 }
 
 NAMESPACE_END(sdlgui)
@@ -14,7 +14,9 @@
 #pragma once
 
 #include <sdlgui/widget.h>
+#include <sdlgui/theme.h>
 #include <functional>
+#include <memory>
 
 NAMESPACE_BEGIN(sdlgui)
 
@@ -27,10 +29,63 @@ class  ImageView : public Widget
 {
 public:
     ImageView(Widget* parent, SDL_Texture *texture);
+    ImageView(Widget* parent, SDL_Surface *image);
     ~ImageView();
 
     void bindImage(SDL_Texture* texture);
 
+    /**
+     * \brief Display a CPU image of any size through a tiled mip pyramid.
+     *
+     * The pixels are copied, so the caller keeps ownership of \c image. The
+     * coarser levels are built on a worker thread. Only the tiles visible at
+     * the current scale are uploaded, a few per frame, and the least recently
+     * drawn ones are released once \ref tileCacheSize is exceeded. Images larger
+     * than the renderer's maximum texture size work in this mode.
+     */
+    void bindImage(SDL_Surface* image);
+
+    /// Channels shown for float and 16-bit images; single channels are drawn as gray
+    enum class Channel { RGB, Red, Green, Blue, Alpha };
+    /// Resampling used for float and 16-bit images
+    enum class Filter { Nearest, Bilinear };
+
+    /**
+     * \brief Display a float or 16-bit image without reducing it to 8 bits first.
+     *
+     * \c pixels holds \c channels interleaved samples per pixel: 1 is gray, 2
+     * gray and alpha, 3 RGB and 4 RGBA. 16-bit samples map 65535 to 1.0. The
+     * samples are copied and kept at full precision. Every frame only the part
+     * visible at the current scale is resampled and mapped through \ref exposure,
+     * \ref gamma and \ref channel into a streaming texture the size of the
+     * widget. Panning by whole pixels only processes the newly exposed strips,
+     * and changing a display parameter skips the resampling.
+     */
+    void bindImage(const float* pixels, int width, int height, int channels);
+    void bindImage(const uint16_t* pixels, int width, int height, int channels);
+
+    /// Exposure in stops, applied before the gamma curve
+    float exposure() const { return mExposure; }
+    void setExposure(float exposure) { mExposure = exposure; }
+
+    /// Display gamma; 1 shows the samples linearly
+    float gamma() const { return mGamma; }
+    void setGamma(float gamma) { mGamma = gamma > 0.01f ? gamma : 0.01f; }
+
+    Channel channel() const { return mChannel; }
+    void setChannel(Channel channel) { mChannel = channel; }
+
+    Filter filter() const { return mFilter; }
+    void setFilter(Filter filter) { mFilter = filter; }
+
+    /// Number of resident tile textures kept before the least recently drawn are released
+    int tileCacheSize() const { return mTileCacheSize; }
+    void setTileCacheSize(int tiles) { mTileCacheSize = tiles; }
+
+    /// Tile textures created per frame; missing tiles show a coarser level until then
+    int tileUploadsPerFrame() const { return mTileUploadsPerFrame; }
+    void setTileUploadsPerFrame(int uploads) { mTileUploadsPerFrame = uploads; }
+
     Vector2f positionF() const { return _pos.tofloat(); }
     Vector2f sizeF() const { return mSize.tofloat(); }
 
@@ -62,6 +117,7 @@ public:
     void setPixelInfoCallback(const std::function<std::pair<std::string, Color>(const Vector2i&)>& callback) 
     {
         mPixelInfoCallback = callback;
+        invalidatePixelInfo();
     }
     const std::function<std::pair<std::string, Color>(const Vector2i&)>& pixelInfoCallback() const 
     {
@@ -69,6 +125,9 @@ public:
     }
 #endif // DOXYGEN_SHOULD_SKIP_THIS
 
+    /// Drop the cached pixel info strings, e.g. after the image data behind the callback changed
+    void invalidatePixelInfo() { mPixelInfo.clear(); mPixelInfoExtent = Vector2i::Zero(); }
+
     void setFontScaleFactor(float fontScaleFactor) { mFontScaleFactor = fontScaleFactor; }
     float fontScaleFactor() const { return mFontScaleFactor; }
 
@@ -132,6 +191,7 @@ public:
     void draw(SDL_Renderer* renderer);
 
     ImageView& withImage(SDL_Texture *texture) { bindImage(texture); return *this; }
+    ImageView& withImage(SDL_Surface *image) { bindImage(image); return *this; }
 
 private:
     // Helper image methods.
@@ -140,16 +200,30 @@ private:
     // Helper drawing methods.
     void drawWidgetBorder(SDL_Renderer* ctx, const SDL_Point& ap) const;
     void drawImageBorder(SDL_Renderer* ctx, const SDL_Point& ap) const;
-    void drawHelpers(SDL_Renderer* ctx) const;
-    static void drawPixelGrid(SDL_Renderer* ctx, const Vector2f& upperLeftCorner,
-                              const Vector2f& lowerRightCorner, const float stride);
-    void drawPixelInfo(SDL_Renderer* ctx, const float stride) const;
-    void writePixelInfo(SDL_Renderer* ctx, const Vector2f& cellPosition,
-                        const Vector2i& pixel, const float stride) const;
+    void drawTiles(SDL_Renderer* ctx, const SDL_Point& ap);
+    void drawProcessed(SDL_Renderer* ctx, const SDL_Point& ap);
+    void drawHelpers(SDL_Renderer* ctx);
+    void drawPixelGrid(SDL_Renderer* ctx, const Vector2f& upperLeftCorner,
+                       const Vector2f& lowerRightCorner, const SDL_Rect& clip, const float stride);
+    void drawPixelInfo(SDL_Renderer* ctx, const float stride);
+    void writePixelInfo(const GlyphAtlas& atlas, float fontScale, const Vector2f& cellPosition,
+                        const Vector2i& pixel, const float stride);
 
     SDL_Texture* mTexture = nullptr;
     Vector2i mImageSize;
 
+    struct TiledImage;
+    std::shared_ptr<TiledImage> mTiled;
+    int mTileCacheSize = 256;
+    int mTileUploadsPerFrame = 8;
+
+    struct ProcessedImage;
+    std::shared_ptr<ProcessedImage> mProcessed;
+    float mExposure = 0.f;
+    float mGamma = 2.2f;
+    Channel mChannel = Channel::RGB;
+    Filter mFilter = Filter::Nearest;
+
     // Image display parameters.
     float mScale;
     Vector2f mOffset;
@@ -166,6 +240,24 @@ private:
     // Image pixel data display members.
     std::function<std::pair<std::string, Color>(const Vector2i&)> mPixelInfoCallback;
     float mFontScaleFactor = 0.2f;
+
+    /* Callback results for the visible pixels, kept while they stay in view */
+    struct PixelInfo
+    {
+        bool valid = false;
+        std::vector<std::string> rows;
+        SDL_Color color;
+    };
+    std::vector<PixelInfo> mPixelInfo;
+    Vector2i mPixelInfoOrigin, mPixelInfoExtent;
+
+    /* Reused per frame batches for the grid lines and the glyph quads */
+    std::vector<SDL_Point> mGridPoints;
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    std::vector<SDL_Vertex> mGlyphVertices;
+    std::vector<int> mGlyphIndices;
+#endif
+    const GlyphAtlas* mGlyphAtlas = nullptr;
 };
 
 NAMESPACE_END(sdlgui)
@@ -16,6 +16,7 @@ NAMESPACE_BEGIN(sdlgui)
 Label::Label(Widget *parent, const std::string &caption, const std::string &font, int fontSize)
     : Widget(parent), mCaption(caption), mFont(font)
 {
+    mKind |= KindLabel;
     if (mTheme) 
     {
         mFontSize = mTheme->mStandardFontSize;
@@ -31,7 +31,8 @@ Vector2i BoxLayout::preferredSize(SDL_Renderer *ctx, const Widget *widget) const
   Vector2i size(2*mMargin, 2*mMargin);
 
     int yOffset = 0;
-    const Window *window = dynamic_cast<const Window *>(widget);
+    const Window *window = widget->isKind(Widget::KindWindow)
+        ? static_cast<const Window *>(widget) : nullptr;
     if (window && !window->title().empty()) 
     {
         if (mOrientation == Orientation::Vertical)
@@ -76,7 +77,8 @@ void BoxLayout::performLayout(SDL_Renderer *ctx, Widget *widget) const
     int _position = mMargin;
     int yOffset = 0;
 
-    const Window *window = dynamic_cast<const Window *>(widget);
+    const Window *window = widget->isKind(Widget::KindWindow)
+        ? static_cast<const Window *>(widget) : nullptr;
     if (window && !window->title().empty()) 
     {
         if (mOrientation == Orientation::Vertical) 
@@ -137,7 +139,8 @@ Vector2i GroupLayout::preferredSize(SDL_Renderer *ctx, const Widget *widget) con
 {
     int hh = mMargin, ww = 2*mMargin;
 
-    const Window *window = dynamic_cast<const Window *>(widget);
+    const Window *window = widget->isKind(Widget::KindWindow)
+        ? static_cast<const Window *>(widget) : nullptr;
     if (window && !window->title().empty())
         hh += widget->theme()->mWindowHeaderHeight - mMargin/2;
 
@@ -146,7 +149,8 @@ Vector2i GroupLayout::preferredSize(SDL_Renderer *ctx, const Widget *widget) con
     {
         if (!c->visible())
             continue;
-        const Label *label = dynamic_cast<const Label *>(c);
+        const Label *label = c->isKind(Widget::KindLabel)
+            ? static_cast<const Label *>(c) : nullptr;
         if (!first)
             hh += (label == nullptr) ? mSpacing : mGroupSpacing;
         first = false;
@@ -173,7 +177,8 @@ void GroupLayout::performLayout(SDL_Renderer *ctx, Widget *widget) const
     int hh = mMargin, availableWidth =
         (widget->fixedWidth() ? widget->fixedWidth() : widget->width()) - 2*mMargin;
 
-    const Window *window = dynamic_cast<const Window *>(widget);
+    const Window *window = widget->isKind(Widget::KindWindow)
+        ? static_cast<const Window *>(widget) : nullptr;
     if (window && !window->title().empty())
         hh += widget->theme()->mWindowHeaderHeight - mMargin/2;
 
@@ -182,7 +187,8 @@ void GroupLayout::performLayout(SDL_Renderer *ctx, Widget *widget) const
     {
         if (!c->visible())
             continue;
-        const Label *label = dynamic_cast<const Label *>(c);
+        const Label *label = c->isKind(Widget::KindLabel)
+            ? static_cast<const Label *>(c) : nullptr;
         if (!first)
             hh += (label == nullptr) ? mSpacing : mGroupSpacing;
         first = false;
@@ -222,7 +228,8 @@ Vector2i GridLayout::preferredSize(SDL_Renderer *ctx,
          + std::max((int) grid[1].size() - 1, 0) * mSpacing[1]
     );
 
-    const Window *window = dynamic_cast<const Window *>(widget);
+    const Window *window = widget->isKind(Widget::KindWindow)
+        ? static_cast<const Window *>(widget) : nullptr;
     if (window && !window->title().empty())
         size[1] += widget->theme()->mWindowHeaderHeight - mMargin/2;
 
@@ -283,7 +290,8 @@ void GridLayout::performLayout(SDL_Renderer *ctx, Widget *widget) const
     int dim[2] = { (int) grid[0].size(), (int) grid[1].size() };
 
     Vector2i extra = Vector2i::Zero();
-    const Window *window = dynamic_cast<const Window *>(widget);
+    const Window *window = widget->isKind(Widget::KindWindow)
+        ? static_cast<const Window *>(widget) : nullptr;
     if (window && !window->title().empty())
         extra[1] += widget->theme()->mWindowHeaderHeight - mMargin / 2;
 
@@ -387,7 +395,8 @@ Vector2i AdvancedGridLayout::preferredSize(SDL_Renderer *ctx, const Widget *widg
         std::accumulate(grid[1].begin(), grid[1].end(), 0));
 
     Vector2i extra = Vector2i::Constant(2 * mMargin);
-    const Window *window = dynamic_cast<const Window *>(widget);
+    const Window *window = widget->isKind(Widget::KindWindow)
+        ? static_cast<const Window *>(widget) : nullptr;
     if (window && !window->title().empty())
         extra[1] += widget->theme()->mWindowHeaderHeight - mMargin/2;
 
@@ -400,7 +409,8 @@ void AdvancedGridLayout::performLayout(SDL_Renderer *ctx, Widget *widget) const
     computeLayout(ctx, widget, grid);
 
     grid[0].insert(grid[0].begin(), mMargin);
-    const Window *window = dynamic_cast<const Window *>(widget);
+    const Window *window = widget->isKind(Widget::KindWindow)
+        ? static_cast<const Window *>(widget) : nullptr;
     if (window && !window->title().empty())
         grid[1].insert(grid[1].begin(), widget->theme()->mWindowHeaderHeight + mMargin/2);
     else
@@ -457,7 +467,8 @@ void AdvancedGridLayout::computeLayout(SDL_Renderer *ctx, const Widget *widget,
     );
 
     Vector2i extra(2 * mMargin, 2 * mMargin);
-    const Window *window = dynamic_cast<const Window *>(widget);
+    const Window *window = widget->isKind(Widget::KindWindow)
+        ? static_cast<const Window *>(widget) : nullptr;
     if (window && !window->title().empty())
         extra[1] += widget->theme()->mWindowHeaderHeight - mMargin/2;
 
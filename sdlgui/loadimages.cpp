@@ -17,11 +17,26 @@
 #include <SDL2/SDL_image.h>
 #endif
 
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <sys/stat.h>
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 NAMESPACE_BEGIN(sdlgui)
 
-ListImages loadImageDirectory(SDL_Renderer* renderer, const std::string &path) 
+namespace
 {
-  ListImages result;
+  /* Full paths of the PNG files in a directory */
+  std::vector<std::string> listImageFiles(const std::string &path)
+  {
+    std::vector<std::string> result;
 #if !defined(_WIN32)
     DIR *dp = opendir(path.c_str());
     if (!dp)
@@ -40,7 +55,85 @@ ListImages loadImageDirectory(SDL_Renderer* renderer, const std::string &path)
 #endif
         if (strstr(fname, "png") == nullptr)
             continue;
-        std::string fullName = path + "/" + std::string(fname);
+        result.push_back(path + "/" + std::string(fname));
+#if !defined(_WIN32)
+    }
+    closedir(dp);
+#else
+    } while (FindNextFileA(handle, &ffd) != 0);
+    FindClose(handle);
+#endif
+    return result;
+  }
+
+  /* Area average of an ARGB8888 surface down to the smallest size that still covers
+     a thumbSize square; returns the converted source when it is already small enough */
+  SDL_Surface* makeThumbnail(SDL_Surface* image, int thumbSize)
+  {
+    SDL_Surface* src = SDL_ConvertSurfaceFormat(image, SDL_PIXELFORMAT_ARGB8888, 0);
+    if (!src)
+      return nullptr;
+
+    int shortSide = std::min(src->w, src->h);
+    if (shortSide <= thumbSize)
+      return src;
+
+    int tw = std::max(1, (src->w * thumbSize + shortSide - 1) / shortSide);
+    int th = std::max(1, (src->h * thumbSize + shortSide - 1) / shortSide);
+    SDL_Surface* dst = SDL_CreateRGBSurfaceWithFormat(0, tw, th, 32, SDL_PIXELFORMAT_ARGB8888);
+    if (!dst)
+    {
+      SDL_FreeSurface(src);
+      return nullptr;
+    }
+
+    /* Source column span of each destination column, reused for every row */
+    std::vector<int> xs(tw + 1);
+    for (int x = 0; x <= tw; x++)
+      xs[x] = std::max(x * src->w / tw, x > 0 ? xs[x - 1] + 1 : 0);
+    xs[tw] = src->w;
+
+    std::vector<uint32_t> acc(size_t(tw) * 4);
+    for (int y = 0; y < th; y++)
+    {
+      int y0 = y * src->h / th, y1 = std::max(y0 + 1, (y + 1) * src->h / th);
+      std::fill(acc.begin(), acc.end(), 0);
+      for (int sy = y0; sy < y1; sy++)
+      {
+        const uint32_t* row = (const uint32_t*)((const uint8_t*)src->pixels + sy * src->pitch);
+        for (int x = 0; x < tw; x++)
+        {
+          uint32_t* a = &acc[x * 4];
+          for (int sx = xs[x]; sx < xs[x + 1]; sx++)
+          {
+            uint32_t p = row[sx];
+            a[0] += p >> 24;
+            a[1] += (p >> 16) & 0xff;
+            a[2] += (p >> 8) & 0xff;
+            a[3] += p & 0xff;
+          }
+        }
+      }
+
+      uint32_t* out = (uint32_t*)((uint8_t*)dst->pixels + y * dst->pitch);
+      for (int x = 0; x < tw; x++)
+      {
+        uint32_t n = uint32_t((xs[x + 1] - xs[x]) * (y1 - y0));
+        const uint32_t* a = &acc[x * 4];
+        out[x] = ((a[0] / n) << 24) | ((a[1] / n) << 16) | ((a[2] / n) << 8) | (a[3] / n);
+      }
+    }
+
+    SDL_FreeSurface(src);
+    return dst;
+  }
+}
+
+ListImages loadImageDirectory(SDL_Renderer* renderer, const std::string &path)
+{
+  ListImages result;
+  for (const std::string &fullName : listImageFiles(path))
+  {
         SDL_Texture* tex = IMG_LoadTexture(renderer, fullName.c_str());
         if (tex == 0)
             throw std::runtime_error("Could not open image data!");
@@ -48,16 +141,553 @@ ListImages loadImageDirectory(SDL_Renderer* renderer, const std::string &path)
         iminfo.tex = tex;
         iminfo.path = fullName;
         SDL_QueryTexture(tex, nullptr, nullptr, &iminfo.w, &iminfo.h);
-        
+
         result.push_back(iminfo);
-#if !defined(_WIN32)
+  }
+  return result;
+}
+
+/* Thumbnail pack: header, entry table, path strings, then ARGB8888 pixels of every entry */
+namespace
+{
+  const char kPackMagic[4] = { 'S', 'G', 'T', 'P' };
+  const uint32_t kPackVersion = 1;
+
+  struct PackHeader
+  {
+    char magic[4];
+    uint32_t version;
+    uint32_t count;
+    uint32_t thumbSize;
+    uint64_t generation;    // bumped on every rewrite, picks the newer of two pack files
+    uint64_t reserved;
+  };
+
+  struct PackEntry
+  {
+    uint64_t pathOffset;
+    uint64_t pixelsOffset;
+    int64_t mtime;
+    int64_t size;
+    uint32_t pathLength;
+    uint32_t w, h;
+    uint32_t pad;
+  };
+
+  bool fileStamp(const std::string &path, int64_t &mtime, int64_t &size)
+  {
+#if defined(_WIN32)
+    struct _stat64 st;
+    if (_stat64(path.c_str(), &st) != 0)
+      return false;
+#else
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0)
+      return false;
+#endif
+    mtime = (int64_t)st.st_mtime;
+    size = (int64_t)st.st_size;
+    return true;
+  }
+
+  /* Read-only mapping of a whole file */
+  class MappedFile
+  {
+  public:
+    ~MappedFile()
+    {
+#if defined(_WIN32)
+      if (mData)
+        UnmapViewOfFile(mData);
+      if (mMapping)
+        CloseHandle(mMapping);
+      if (mFile != INVALID_HANDLE_VALUE)
+        CloseHandle(mFile);
+#else
+      if (mData)
+        munmap((void*)mData, mSize);
+#endif
     }
-    closedir(dp);
+
+    bool open(const std::string &path)
+    {
+#if defined(_WIN32)
+      mFile = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+      if (mFile == INVALID_HANDLE_VALUE)
+        return false;
+      LARGE_INTEGER size;
+      if (!GetFileSizeEx(mFile, &size) || size.QuadPart == 0)
+        return false;
+      mMapping = CreateFileMappingA(mFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+      if (!mMapping)
+        return false;
+      mData = (const uint8_t*)MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0);
+      mSize = (size_t)size.QuadPart;
 #else
-    } while (FindNextFileA(handle, &ffd) != 0);
-    FindClose(handle);
+      int fd = ::open(path.c_str(), O_RDONLY);
+      if (fd < 0)
+        return false;
+      struct stat st;
+      if (fstat(fd, &st) != 0 || st.st_size == 0)
+      {
+        close(fd);
+        return false;
+      }
+      void* data = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      close(fd);
+      if (data == MAP_FAILED)
+        return false;
+      mData = (const uint8_t*)data;
+      mSize = (size_t)st.st_size;
 #endif
-    return result;
+      return mData != nullptr;
+    }
+
+    const uint8_t* data() const { return mData; }
+    size_t size() const { return mSize; }
+
+  private:
+    const uint8_t* mData = nullptr;
+    size_t mSize = 0;
+#if defined(_WIN32)
+    HANDLE mFile = INVALID_HANDLE_VALUE;
+    HANDLE mMapping = nullptr;
+#endif
+  };
+}
+
+struct ImageDirectoryLoader::State
+{
+  /* Cache key and thumbnail of one file; pixels point into the pack or into 'owned'.
+     Slots change only under 'mutex': workers fill them, and writePack moves 'owned'
+     pixels into the new pack and frees them, so memory stays bounded by the pack */
+  struct Slot
+  {
+    int64_t mtime = 0, size = 0;
+    bool stamped = false;
+    int w = 0, h = 0;
+    const uint32_t* pixels = nullptr;
+    std::vector<uint32_t> owned;
+  };
+
+  std::vector<std::string> files;
+  std::vector<Slot> slots;
+  int thumbSize;
+  std::string cachePath;
+  std::shared_ptr<MappedFile> pack;
+  int packFile = 0;           // which of the two pack names 'pack' was read from
+  uint64_t packGeneration = 0;
+  size_t maxWorkers = 1;
+
+  std::atomic<bool> cancel{ false };
+
+  std::mutex mutex;
+  std::deque<int> queue;      // files waiting for a worker, front first
+  size_t activeWorkers = 0;
+  bool packDirty = false;
+
+  /* Thumbnail waiting for upload; 'mapping' keeps the pack a wrapped surface points into */
+  struct Ready
+  {
+    int index;
+    SDL_Surface* surface;
+    std::shared_ptr<MappedFile> mapping;
+  };
+  std::deque<Ready> ready;
+
+  std::mutex writeMutex;
+
+  ~State()
+  {
+    for (auto& r : ready)
+      SDL_FreeSurface(r.surface);
+  }
+
+  /* Call with 'mutex' held. Pack pixels are wrapped without copying, pixels that are
+     not persisted yet are copied since writePack frees them */
+  void pushCached(int index)
+  {
+    const Slot& slot = slots[index];
+    SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormatFrom((void*)slot.pixels, slot.w, slot.h, 32,
+                                                              slot.w * sizeof(uint32_t), SDL_PIXELFORMAT_ARGB8888);
+    if (surface && !slot.owned.empty())
+    {
+      SDL_Surface* copy = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_ARGB8888, 0);
+      SDL_FreeSurface(surface);
+      ready.push_back({ index, copy, nullptr });
+    }
+    else
+      ready.push_back({ index, surface, pack });
+  }
+
+  /* Call with 'mutex' held */
+  void startWorkers(const std::shared_ptr<State>& self)
+  {
+    while (activeWorkers < maxWorkers && activeWorkers < queue.size())
+    {
+      activeWorkers++;
+      runAsync([self]() { self->work(); });
+    }
+  }
+
+  /* Windows cannot replace a file while it is mapped, so there the pack alternates
+     between two names and the header generation tells which one is current */
+  std::string packPath(int which) const
+  {
+    return which ? cachePath + ".1" : cachePath;
+  }
+
+  /* Map a pack file and check its header, nullptr if it is missing or unusable */
+  std::shared_ptr<MappedFile> openPack(const std::string &path) const
+  {
+    std::shared_ptr<MappedFile> mapped = std::make_shared<MappedFile>();
+    if (!mapped->open(path) || mapped->size() < sizeof(PackHeader))
+      return nullptr;
+
+    const uint64_t size = mapped->size();
+    const PackHeader* header = (const PackHeader*)mapped->data();
+    if (memcmp(header->magic, kPackMagic, 4) != 0 || header->version != kPackVersion
+        || header->thumbSize != (uint32_t)thumbSize
+        || uint64_t(header->count) > (size - sizeof(PackHeader)) / sizeof(PackEntry))
+      return nullptr;
+    return mapped;
+  }
+
+  /* Resolve every file that the pack already holds with the same mtime and size */
+  void readPack()
+  {
+    if (cachePath.empty())
+      return;
+    pack = openPack(packPath(0));
+#if defined(_WIN32)
+    std::shared_ptr<MappedFile> other = openPack(packPath(1));
+    if (other && (!pack || ((const PackHeader*)other->data())->generation
+                           > ((const PackHeader*)pack->data())->generation))
+    {
+      pack = other;
+      packFile = 1;
+    }
+#endif
+    if (!pack)
+      return;
+
+    const uint8_t* base = pack->data();
+    const uint64_t size = pack->size();
+    const PackHeader* header = (const PackHeader*)base;
+    packGeneration = header->generation;
+
+    std::unordered_map<std::string, int> byPath;
+    for (size_t i = 0; i < files.size(); i++)
+      byPath[files[i]] = (int)i;
+
+    const PackEntry* entries = (const PackEntry*)(base + sizeof(PackHeader));
+    for (uint32_t e = 0; e < header->count; e++)
+    {
+      const PackEntry& entry = entries[e];
+      uint64_t pixelBytes = uint64_t(entry.w) * entry.h * sizeof(uint32_t);
+      /* Compared as offset/remaining so a corrupt pack cannot wrap the sums */
+      if (entry.pathOffset > size || entry.pathLength > size - entry.pathOffset
+          || entry.pixelsOffset > size || pixelBytes > size - entry.pixelsOffset
+          || entry.pixelsOffset % sizeof(uint32_t) != 0)
+        continue;
+
+      auto it = byPath.find(std::string((const char*)base + entry.pathOffset, entry.pathLength));
+      if (it == byPath.end())
+        continue;
+      Slot& slot = slots[it->second];
+      if (!slot.stamped || slot.mtime != entry.mtime || slot.size != entry.size)
+        continue;
+
+      slot.w = entry.w;
+      slot.h = entry.h;
+      slot.pixels = (const uint32_t*)(base + entry.pixelsOffset);
+    }
+  }
+
+  /* Rewrite the pack next to the old one and swap it in; the old mapping stays valid.
+     On Windows the other of the two pack names is written, since the current one is mapped */
+  void writePack()
+  {
+    std::lock_guard<std::mutex> writing(writeMutex);
+
+    std::vector<int> stored;
+    {
+      std::lock_guard<std::mutex> guard(mutex);
+      for (size_t i = 0; i < slots.size(); i++)
+        if (slots[i].pixels && slots[i].stamped)
+          stored.push_back((int)i);
+      packDirty = false;
+    }
+
+#if defined(_WIN32)
+    const int target = 1 - packFile;
+#else
+    const int target = packFile;
+#endif
+    const std::string path = packPath(target);
+    std::string tmp = path + ".tmp";
+    FILE* f = fopen(tmp.c_str(), "wb");
+    if (!f)
+      return;
+
+    PackHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, kPackMagic, 4);
+    header.version = kPackVersion;
+    header.count = (uint32_t)stored.size();
+    header.thumbSize = (uint32_t)thumbSize;
+    header.generation = packGeneration + 1;
+
+    std::vector<PackEntry> entries(stored.size());
+    uint64_t offset = sizeof(PackHeader) + entries.size() * sizeof(PackEntry);
+    for (size_t e = 0; e < stored.size(); e++)
+    {
+      entries[e].pathOffset = offset;
+      entries[e].pathLength = (uint32_t)files[stored[e]].size();
+      offset += entries[e].pathLength;
+    }
+    offset = (offset + 3) & ~uint64_t(3);
+    for (size_t e = 0; e < stored.size(); e++)
+    {
+      const Slot& slot = slots[stored[e]];
+      entries[e].pixelsOffset = offset;
+      entries[e].mtime = slot.mtime;
+      entries[e].size = slot.size;
+      entries[e].w = slot.w;
+      entries[e].h = slot.h;
+      offset += uint64_t(slot.w) * slot.h * sizeof(uint32_t);
+    }
+
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1;
+    ok = ok && (entries.empty() || fwrite(entries.data(), sizeof(PackEntry), entries.size(), f) == entries.size());
+    uint64_t written = sizeof(PackHeader) + entries.size() * sizeof(PackEntry);
+    for (int i : stored)
+    {
+      ok = ok && fwrite(files[i].data(), 1, files[i].size(), f) == files[i].size();
+      written += files[i].size();
+    }
+    static const char zeros[4] = { 0, 0, 0, 0 };
+    size_t pad = (size_t)(((written + 3) & ~uint64_t(3)) - written);
+    ok = ok && fwrite(zeros, 1, pad, f) == pad;
+    for (int i : stored)
+    {
+      size_t n = size_t(slots[i].w) * slots[i].h;
+      ok = ok && fwrite(slots[i].pixels, sizeof(uint32_t), n, f) == n;
+    }
+    ok = fclose(f) == 0 && ok;
+
+#if defined(_WIN32)
+    /* Fails while queued surfaces still use the pack from two rewrites ago */
+    ok = ok && MoveFileExA(tmp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING);
+#else
+    ok = ok && rename(tmp.c_str(), path.c_str()) == 0;
+#endif
+    if (!ok)
+    {
+      remove(tmp.c_str());
+      std::lock_guard<std::mutex> guard(mutex);
+      packDirty = true;   // retried when the workers next go idle
+      return;
+    }
+
+    /* Serve the persisted thumbnails from the new pack and drop their private copies.
+       The old mapping lives on while queued surfaces still point into it */
+    std::shared_ptr<MappedFile> mapped = std::make_shared<MappedFile>();
+    packFile = target;
+    packGeneration = header.generation;
+    if (!mapped->open(path) || mapped->size() < offset)
+      return;
+    std::lock_guard<std::mutex> guard(mutex);
+    for (size_t e = 0; e < stored.size(); e++)
+    {
+      Slot& slot = slots[stored[e]];
+      slot.pixels = (const uint32_t*)(mapped->data() + entries[e].pixelsOffset);
+      std::vector<uint32_t>().swap(slot.owned);
+    }
+    pack = mapped;
+  }
+
+  /* Worker loop: decode queued files until the queue is empty */
+  void work()
+  {
+    for (;;)
+    {
+      int i;
+      {
+        std::lock_guard<std::mutex> guard(mutex);
+        if (queue.empty() || cancel.load())
+        {
+          /* The last worker to go idle refreshes the pack */
+          bool write = --activeWorkers == 0 && packDirty && !cancel.load();
+          if (!write)
+            return;
+          i = -1;
+        }
+        else
+        {
+          i = queue.front();
+          queue.pop_front();
+        }
+      }
+
+      if (i < 0)
+      {
+        writePack();
+        return;
+      }
+
+      SDL_Surface* thumb = nullptr;
+      if (SDL_Surface* image = IMG_Load(files[i].c_str()))
+      {
+        thumb = makeThumbnail(image, thumbSize);
+        SDL_FreeSurface(image);
+      }
+
+      std::vector<uint32_t> copy;
+      if (thumb && !cachePath.empty() && slots[i].stamped)
+      {
+        copy.resize(size_t(thumb->w) * thumb->h);
+        for (int y = 0; y < thumb->h; y++)
+          memcpy(copy.data() + size_t(y) * thumb->w, (uint8_t*)thumb->pixels + y * thumb->pitch, thumb->w * sizeof(uint32_t));
+      }
+
+      std::lock_guard<std::mutex> guard(mutex);
+      if (!copy.empty())
+      {
+        Slot& slot = slots[i];
+        slot.w = thumb->w;
+        slot.h = thumb->h;
+        slot.owned = std::move(copy);
+        slot.pixels = slot.owned.data();
+        packDirty = true;
+      }
+      ready.push_back({ i, thumb, nullptr });
+    }
+  }
+};
+
+ImageDirectoryLoader::ImageDirectoryLoader(const std::string &path, int thumbSize,
+                                           const std::string &cachePath, bool onDemand)
+  : mState(std::make_shared<State>()), mOnDemand(onDemand)
+{
+  State& s = *mState;
+  s.files = listImageFiles(path);
+  s.thumbSize = thumbSize;
+  s.cachePath = cachePath;
+  s.slots.resize(s.files.size());
+  s.maxWorkers = std::max(1u, std::thread::hardware_concurrency());
+
+  mImages.resize(s.files.size());
+  mStatus.assign(s.files.size(), Idle);
+  for (size_t i = 0; i < mImages.size(); i++)
+  {
+    mImages[i].path = s.files[i];
+    mImages[i].w = mImages[i].h = thumbSize;
+  }
+
+  if (!cachePath.empty())
+  {
+    for (size_t i = 0; i < s.files.size(); i++)
+      s.slots[i].stamped = fileStamp(s.files[i], s.slots[i].mtime, s.slots[i].size);
+    s.readPack();
+  }
+
+  if (!onDemand)
+    for (size_t i = 0; i < s.files.size(); i++)
+      request((int)i);
+}
+
+ImageDirectoryLoader::~ImageDirectoryLoader()
+{
+  mState->cancel = true;
+  for (ImageInfo& info : mImages)
+    if (info.tex)
+      SDL_DestroyTexture(info.tex);
+}
+
+void ImageDirectoryLoader::request(int index)
+{
+  if (mStatus[index] != Idle)
+    return;
+  mStatus[index] = Queued;
+
+  /* Cached thumbnails are wrapped in place and wait for upload, the rest is decoded.
+     Slots only gain pixels under the lock, so a miss here is re-checked below */
+  State& s = *mState;
+  std::lock_guard<std::mutex> guard(s.mutex);
+  if (s.slots[index].pixels)
+    s.pushCached(index);
+  else
+  {
+    if (mOnDemand)
+      s.queue.push_front(index); // the most recent request is the one on screen
+    else
+      s.queue.push_back(index);
+    s.startWorkers(mState);
+  }
+}
+
+void ImageDirectoryLoader::release(int index)
+{
+  if (mStatus[index] == Queued)
+  {
+    /* Still waiting for a worker: just drop it from the queue */
+    State& s = *mState;
+    std::lock_guard<std::mutex> guard(s.mutex);
+    auto it = std::find(s.queue.begin(), s.queue.end(), index);
+    if (it != s.queue.end())
+    {
+      s.queue.erase(it);
+      mStatus[index] = Idle;
+    }
+    return;
+  }
+
+  if (mStatus[index] != Resident)
+    return;
+  ImageInfo& info = mImages[index];
+  if (info.tex)
+    SDL_DestroyTexture(info.tex);
+  info.tex = nullptr;
+  info.w = info.h = mState->thumbSize;
+  mStatus[index] = Idle;
+}
+
+int ImageDirectoryLoader::upload(SDL_Renderer* renderer, int budget, std::vector<int>* updated)
+{
+  int count = 0;
+  while (count < budget)
+  {
+    State::Ready item;
+    {
+      std::lock_guard<std::mutex> guard(mState->mutex);
+      if (mState->ready.empty())
+        break;
+      item = std::move(mState->ready.front());
+      mState->ready.pop_front();
+    }
+
+    mStatus[item.index] = item.surface ? Resident : Failed;
+    if (!item.surface)
+      continue; // decode failed, the entry keeps its placeholder
+
+    ImageInfo& info = mImages[item.index];
+    info.tex = SDL_CreateTextureFromSurface(renderer, item.surface);
+    info.w = item.surface->w;
+    info.h = item.surface->h;
+    SDL_FreeSurface(item.surface);
+
+    if (updated)
+      updated->push_back(item.index);
+    count++;
+  }
+  return count;
+}
+
+bool ImageDirectoryLoader::finished() const
+{
+  std::lock_guard<std::mutex> guard(mState->mutex);
+  return mState->queue.empty() && mState->ready.empty() && mState->activeWorkers == 0;
 }
 
-NAMESPACE_END(sdlgui)
\ No newline at end of file
+NAMESPACE_END(sdlgui)
@@ -0,0 +1,13 @@
+/*
+    sdlgui/nanovg_rt.cpp -- The only translation unit that compiles the
+    NanoRT software rasterizer and its NanoVG back-end
+
+    Adaptation for SDL by Dalerank <dalerankn8@gmail.com>
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+
+#define NANOVG_RT_IMPLEMENTATION
+#define NANORT_IMPLEMENTATION
+#include "nanovg_rt.h"
@@ -40,7 +40,7 @@
 #ifndef NANOVG_RT_H
 #define NANOVG_RT_H
 
-#include "nanort.h"
+#include "nanovg.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -83,7 +83,7 @@ enum NVGimageFlagsRT {
 #include <stdio.h>
 #include <string.h>
 #include <math.h>
-#include "nanovg.h"
+#include "nanort.h"
 
 namespace {
 
@@ -2405,7 +2405,7 @@ static void rtnvg__renderDelete(void *uptr) {
   free(rt);
 }
 
-inline NVGcontext *nvgCreateRT(int flags, int w, int h, int clrColor) {
+NVGcontext *nvgCreateRT(int flags, int w, int h, int clrColor) {
   NVGparams params;
   NVGcontext *ctx = NULL;
   RTNVGcontext *rt = (RTNVGcontext *)malloc(sizeof(RTNVGcontext));
@@ -2451,14 +2451,14 @@ error:
   return NULL;
 }
 
-inline void nvgDeleteRT(NVGcontext *ctx) {
+void nvgDeleteRT(NVGcontext *ctx) {
   RTNVGcontext *rt = (RTNVGcontext *)nvgInternalParams(ctx)->userPtr;
   free(rt->pixels);
   // printf("delete\n");
   nvgDeleteInternal(ctx);
 }
 
-inline int nvglCreateImageFromHandle(NVGcontext *ctx, unsigned int textureId, int w,
+int nvglCreateImageFromHandle(NVGcontext *ctx, unsigned int textureId, int w,
                               int h, int imageFlags) {
   RTNVGcontext *rt = (RTNVGcontext *)nvgInternalParams(ctx)->userPtr;
   RTNVGtexture *tex = rtnvg__allocTexture(rt);
@@ -2477,13 +2477,13 @@ inline int nvglCreateImageFromHandle(NVGcontext *ctx, unsigned int textureId, in
   return tex->id;
 }
 
-inline unsigned int nvglImageHandle(NVGcontext *ctx, int image) {
+unsigned int nvglImageHandle(NVGcontext *ctx, int image) {
   RTNVGcontext *rt = (RTNVGcontext *)nvgInternalParams(ctx)->userPtr;
   RTNVGtexture *tex = rtnvg__findTexture(rt, image);
   return tex->tex;
 }
 
-inline void nvgClearBackgroundRT(NVGcontext *ctx, float r, float g, float b, float a) {
+void nvgClearBackgroundRT(NVGcontext *ctx, float r, float g, float b, float a) {
   RTNVGcontext *rt = (RTNVGcontext *)nvgInternalParams(ctx)->userPtr;
   unsigned char red = ftouc(r);
   unsigned char green = ftouc(g);
@@ -2497,7 +2497,7 @@ inline void nvgClearBackgroundRT(NVGcontext *ctx, float r, float g, float b, flo
   }
 }
 
-inline unsigned char *nvgReadPixelsRT(NVGcontext *ctx) {
+unsigned char *nvgReadPixelsRT(NVGcontext *ctx) {
   RTNVGcontext *rt = (RTNVGcontext *)nvgInternalParams(ctx)->userPtr;
   return rt->pixels;
 }
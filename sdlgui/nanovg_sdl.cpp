@@ -0,0 +1,551 @@
+/*
+    sdlgui/nanovg_sdl.cpp -- NanoVG back-end that draws straight into an SDL_Renderer
+
+    Adaptation for SDL by Dalerank <dalerankn8@gmail.com>
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+
+#include "nanovg_sdl.h"
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(_WIN32)
+#include <SDL.h>
+#else
+#include <SDL2/SDL.h>
+#endif
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+
+namespace
+{
+
+struct SDLNVGtexture
+{
+  SDL_Texture* tex = nullptr;
+  int type = 0;
+  int w = 0, h = 0;
+  int flags = 0;
+};
+
+struct SDLNVGcontext
+{
+  SDL_Renderer* renderer = nullptr;
+  int flags = 0;
+  std::vector<SDLNVGtexture> textures; // image handle is index + 1
+  std::vector<SDL_Vertex> verts;
+  std::vector<int> indices;
+  std::vector<std::pair<float, int>> crossings; // x and edge direction
+  std::vector<float> rowSpans, openSpans;
+  std::vector<int> openTop;
+};
+
+/* Per-vertex paint evaluation, mirrors the fragment shader of the GL back-ends */
+struct PaintEval
+{
+  float inv[6];
+  float extent[2];
+  float radius, feather;
+  NVGcolor inner, outer;
+  bool image, flipy;
+
+  PaintEval(const NVGpaint& paint, const SDLNVGtexture* tex)
+  {
+    nvgTransformInverse(inv, paint.xform);
+    extent[0] = paint.extent[0];
+    extent[1] = paint.extent[1];
+    radius = paint.radius;
+    feather = std::max(paint.feather, 1e-4f);
+    inner = paint.innerColor;
+    outer = paint.outerColor;
+    image = tex != nullptr;
+    flipy = tex && (tex->flags & NVG_IMAGE_FLIPY);
+  }
+
+  static Uint8 channel(float c) { return (Uint8)std::min(255.f, std::max(0.f, c * 255.f + 0.5f)); }
+
+  SDL_Vertex vertex(float x, float y, float alpha) const
+  {
+    float px = inv[0] * x + inv[2] * y + inv[4];
+    float py = inv[1] * x + inv[3] * y + inv[5];
+
+    SDL_Vertex v;
+    v.position.x = x;
+    v.position.y = y;
+    v.tex_coord.x = 0;
+    v.tex_coord.y = 0;
+
+    NVGcolor c = inner;
+    if (image)
+    {
+      v.tex_coord.x = px / extent[0];
+      v.tex_coord.y = flipy ? 1.f - py / extent[1] : py / extent[1];
+    }
+    else
+    {
+      // Signed distance to the paint rounded rect, then blend across the feather
+      float ex = extent[0] - radius, ey = extent[1] - radius;
+      float dx = std::fabs(px) - ex, dy = std::fabs(py) - ey;
+      float mx = std::max(dx, 0.f), my = std::max(dy, 0.f);
+      float sd = std::min(std::max(dx, dy), 0.f) + std::sqrt(mx * mx + my * my) - radius;
+      float t = std::min(1.f, std::max(0.f, (sd + feather * 0.5f) / feather));
+      c.r = inner.r + (outer.r - inner.r) * t;
+      c.g = inner.g + (outer.g - inner.g) * t;
+      c.b = inner.b + (outer.b - inner.b) * t;
+      c.a = inner.a + (outer.a - inner.a) * t;
+    }
+
+    v.color.r = channel(c.r);
+    v.color.g = channel(c.g);
+    v.color.b = channel(c.b);
+    v.color.a = channel(c.a * alpha);
+    return v;
+  }
+};
+
+SDLNVGtexture* findTexture(SDLNVGcontext* sdl, int image)
+{
+  if (image <= 0 || image > (int)sdl->textures.size() || !sdl->textures[image - 1].tex)
+    return nullptr;
+  return &sdl->textures[image - 1];
+}
+
+SDL_BlendMode blendMode(const NVGcompositeOperationState& op)
+{
+  if (op.srcRGB == NVG_ONE && op.dstRGB == NVG_ONE)
+    return SDL_BLENDMODE_ADD;
+  return SDL_BLENDMODE_BLEND;
+}
+
+/* Applies an axis aligned NanoVG scissor on top of the renderer clip rect */
+class ScissorScope
+{
+public:
+  ScissorScope(SDL_Renderer* renderer, const NVGscissor& scissor) : mRenderer(renderer)
+  {
+    mHadClip = SDL_RenderIsClipEnabled(renderer) == SDL_TRUE;
+    if (mHadClip)
+      SDL_RenderGetClipRect(renderer, &mClip);
+
+    // Rotated scissors are ignored, widgets only translate
+    if (scissor.extent[0] < -0.5f || scissor.extent[1] < -0.5f
+        || scissor.xform[1] != 0.f || scissor.xform[2] != 0.f)
+      return;
+
+    float ex = scissor.extent[0] * std::fabs(scissor.xform[0]);
+    float ey = scissor.extent[1] * std::fabs(scissor.xform[3]);
+    SDL_Rect r{ (int)std::floor(scissor.xform[4] - ex), (int)std::floor(scissor.xform[5] - ey), 0, 0 };
+    r.w = (int)std::ceil(scissor.xform[4] + ex) - r.x;
+    r.h = (int)std::ceil(scissor.xform[5] + ey) - r.y;
+
+    if (mHadClip)
+    {
+      SDL_Rect clipped;
+      if (!SDL_IntersectRect(&r, &mClip, &clipped))
+        clipped = SDL_Rect{ r.x, r.y, 0, 0 };
+      r = clipped;
+    }
+    SDL_RenderSetClipRect(renderer, &r);
+    mChanged = true;
+  }
+
+  ~ScissorScope()
+  {
+    if (mChanged)
+      SDL_RenderSetClipRect(mRenderer, mHadClip ? &mClip : nullptr);
+  }
+
+private:
+  SDL_Renderer* mRenderer;
+  SDL_Rect mClip{ 0, 0, 0, 0 };
+  bool mHadClip = false;
+  bool mChanged = false;
+};
+
+void submit(SDLNVGcontext* sdl, const NVGpaint& paint, const NVGcompositeOperationState& op, const NVGscissor& scissor)
+{
+  if (sdl->indices.empty())
+    return;
+
+  SDLNVGtexture* tex = findTexture(sdl, paint.image);
+  SDL_Texture* handle = tex ? tex->tex : nullptr;
+  SDL_BlendMode mode = blendMode(op);
+  if (handle)
+    SDL_SetTextureBlendMode(handle, mode);
+  else
+    SDL_SetRenderDrawBlendMode(sdl->renderer, mode);
+
+  ScissorScope scope(sdl->renderer, scissor);
+  SDL_RenderGeometry(sdl->renderer, handle, sdl->verts.data(), (int)sdl->verts.size(),
+                     sdl->indices.data(), (int)sdl->indices.size());
+}
+
+/* Triangle strip as produced by nanovg.c for strokes and fill fringes */
+void appendStrip(SDLNVGcontext* sdl, const PaintEval& pe, const NVGvertex* v, int n, bool fringeAlpha)
+{
+  if (n < 3)
+    return;
+
+  int base = (int)sdl->verts.size();
+  for (int i = 0; i < n; i++)
+  {
+    // Fill fringes fade from u = 0.5 (edge) to u = 0 or 1 (outside)
+    float alpha = fringeAlpha ? std::min(1.f, 1.f - std::fabs(v[i].u * 2.f - 1.f)) * std::min(1.f, v[i].v) : 1.f;
+    sdl->verts.push_back(pe.vertex(v[i].x, v[i].y, alpha));
+  }
+
+  for (int i = 2; i < n; i++)
+  {
+    sdl->indices.push_back(base + i - 2);
+    sdl->indices.push_back(base + i - 1);
+    sdl->indices.push_back(base + i);
+  }
+}
+
+/* Antialiased stroke strip. NanoVG widened it by the fringe and put the coverage ramp
+   across it in u, which vertex colors cannot plateau, so the outer vertices are pulled
+   back to the true stroke edge instead and only the cap ramp in v is kept */
+void appendStroke(SDLNVGcontext* sdl, const PaintEval& pe, const NVGvertex* v, int n, float fringe)
+{
+  if (n < 3)
+    return;
+
+  int base = (int)sdl->verts.size();
+  for (int i = 0; i < n; i++)
+  {
+    float x = v[i].x, y = v[i].y;
+    // Vertices come in side/side or side/center pairs; u = 0.5 marks a center or a non-AA stroke
+    int j = i ^ 1;
+    if (j < n && v[i].u != 0.5f)
+    {
+      float dx = v[j].x - x, dy = v[j].y - y;
+      float len = std::sqrt(dx * dx + dy * dy);
+      if (len > 0.f)
+      {
+        float t = std::min(fringe * 0.5f, len * 0.5f) / len;
+        x += dx * t;
+        y += dy * t;
+      }
+    }
+    sdl->verts.push_back(pe.vertex(x, y, std::min(1.f, v[i].v)));
+  }
+
+  for (int i = 2; i < n; i++)
+  {
+    sdl->indices.push_back(base + i - 2);
+    sdl->indices.push_back(base + i - 1);
+    sdl->indices.push_back(base + i);
+  }
+}
+
+/* Convex polygon, fanned around its centroid so box gradients keep an interior sample */
+void appendConvex(SDLNVGcontext* sdl, const PaintEval& pe, const NVGvertex* v, int n)
+{
+  if (n < 3)
+    return;
+
+  float cx = 0, cy = 0;
+  for (int i = 0; i < n; i++)
+  {
+    cx += v[i].x;
+    cy += v[i].y;
+  }
+
+  int center = (int)sdl->verts.size();
+  sdl->verts.push_back(pe.vertex(cx / n, cy / n, 1.f));
+  for (int i = 0; i < n; i++)
+    sdl->verts.push_back(pe.vertex(v[i].x, v[i].y, 1.f));
+
+  for (int i = 0; i < n; i++)
+  {
+    sdl->indices.push_back(center);
+    sdl->indices.push_back(center + 1 + i);
+    sdl->indices.push_back(center + 1 + (i + 1) % n);
+  }
+}
+
+void appendQuad(SDLNVGcontext* sdl, const PaintEval& pe, float x0, float y0, float x1, float y1)
+{
+  int base = (int)sdl->verts.size();
+  sdl->verts.push_back(pe.vertex(x0, y0, 1.f));
+  sdl->verts.push_back(pe.vertex(x1, y0, 1.f));
+  sdl->verts.push_back(pe.vertex(x1, y1, 1.f));
+  sdl->verts.push_back(pe.vertex(x0, y1, 1.f));
+
+  const int quad[6] = { 0, 1, 2, 0, 2, 3 };
+  for (int i : quad)
+    sdl->indices.push_back(base + i);
+}
+
+/* Concave shapes and holes cannot be fanned and SDL has no stencil buffer, so they are
+   resolved with the non-zero rule one pixel row at a time. Rows with identical spans
+   are merged into a single quad, which keeps rects with rounded holes cheap. */
+void appendScanlines(SDLNVGcontext* sdl, const PaintEval& pe, const float* bounds, const NVGpath* paths, int npaths)
+{
+  int y0 = (int)std::floor(bounds[1]);
+  int y1 = (int)std::ceil(bounds[3]);
+
+  auto flush = [&](int bottom) {
+    for (size_t i = 0; i < sdl->openTop.size(); i++)
+      appendQuad(sdl, pe, sdl->openSpans[2 * i], (float)sdl->openTop[i], sdl->openSpans[2 * i + 1], (float)bottom);
+    sdl->openSpans.clear();
+    sdl->openTop.clear();
+  };
+
+  sdl->openSpans.clear();
+  sdl->openTop.clear();
+  for (int y = y0; y < y1; y++)
+  {
+    float yc = y + 0.5f;
+
+    sdl->crossings.clear();
+    for (int p = 0; p < npaths; p++)
+    {
+      const NVGvertex* v = paths[p].fill;
+      int n = paths[p].nfill;
+      for (int i = 0, j = n - 1; i < n; j = i++)
+      {
+        float ay = v[j].y, by = v[i].y;
+        if (ay == by || yc < std::min(ay, by) || yc >= std::max(ay, by))
+          continue;
+        float x = v[j].x + (yc - ay) * (v[i].x - v[j].x) / (by - ay);
+        sdl->crossings.push_back(std::make_pair(x, by > ay ? 1 : -1));
+      }
+    }
+
+    std::sort(sdl->crossings.begin(), sdl->crossings.end());
+
+    sdl->rowSpans.clear();
+    int winding = 0;
+    for (auto& c : sdl->crossings)
+    {
+      int next = winding + c.second;
+      if ((winding == 0) != (next == 0))
+        sdl->rowSpans.push_back(c.first);
+      winding = next;
+    }
+
+    bool same = sdl->rowSpans.size() == sdl->openSpans.size();
+    for (size_t i = 0; same && i < sdl->rowSpans.size(); i++)
+      same = std::fabs(sdl->rowSpans[i] - sdl->openSpans[i]) < 0.01f;
+
+    if (!same)
+    {
+      flush(y);
+      sdl->openSpans = sdl->rowSpans;
+      sdl->openTop.assign(sdl->openSpans.size() / 2, y);
+    }
+  }
+  flush(y1);
+}
+
+int renderCreate(void*) { return 1; }
+
+int renderUpdateTexture(void* uptr, int image, int x, int y, int w, int h, const unsigned char* data);
+
+int renderCreateTexture(void* uptr, int type, int w, int h, int imageFlags, const unsigned char* data)
+{
+  SDLNVGcontext* sdl = (SDLNVGcontext*)uptr;
+
+  SDLNVGtexture t;
+  t.tex = SDL_CreateTexture(sdl->renderer, SDL_PIXELFORMAT_ABGR8888, SDL_TEXTUREACCESS_STATIC, w, h);
+  if (!t.tex)
+    return 0;
+  t.type = type;
+  t.w = w;
+  t.h = h;
+  t.flags = imageFlags;
+
+  int image = 0;
+  for (size_t i = 0; i < sdl->textures.size() && !image; i++)
+    if (!sdl->textures[i].tex)
+    {
+      sdl->textures[i] = t;
+      image = (int)i + 1;
+    }
+
+  if (!image)
+  {
+    sdl->textures.push_back(t);
+    image = (int)sdl->textures.size();
+  }
+
+  if (data)
+    renderUpdateTexture(uptr, image, 0, 0, w, h, data);
+  return image;
+}
+
+int renderDeleteTexture(void* uptr, int image)
+{
+  SDLNVGcontext* sdl = (SDLNVGcontext*)uptr;
+  SDLNVGtexture* tex = findTexture(sdl, image);
+  if (!tex)
+    return 0;
+
+  SDL_DestroyTexture(tex->tex);
+  *tex = SDLNVGtexture();
+  return 1;
+}
+
+int renderUpdateTexture(void* uptr, int image, int x, int y, int w, int h, const unsigned char* data)
+{
+  SDLNVGcontext* sdl = (SDLNVGcontext*)uptr;
+  SDLNVGtexture* tex = findTexture(sdl, image);
+  if (!tex)
+    return 0;
+
+  // Like the GL2 back-end, whole rows are uploaded
+  NVG_NOTUSED(x);
+  NVG_NOTUSED(w);
+  SDL_Rect rect{ 0, y, tex->w, h };
+
+  if (tex->type == NVG_TEXTURE_RGBA)
+  {
+    SDL_UpdateTexture(tex->tex, &rect, data + (size_t)y * tex->w * 4, tex->w * 4);
+    return 1;
+  }
+
+  // Alpha textures (font atlases) are expanded to white so vertex colors tint them
+  std::vector<Uint32> rgba((size_t)tex->w * h);
+  const unsigned char* src = data + (size_t)y * tex->w;
+  for (size_t i = 0; i < rgba.size(); i++)
+    rgba[i] = 0x00ffffffu | ((Uint32)src[i] << 24);
+  SDL_UpdateTexture(tex->tex, &rect, rgba.data(), tex->w * 4);
+  return 1;
+}
+
+int renderGetTextureSize(void* uptr, int image, int* w, int* h)
+{
+  SDLNVGtexture* tex = findTexture((SDLNVGcontext*)uptr, image);
+  if (!tex)
+    return 0;
+  *w = tex->w;
+  *h = tex->h;
+  return 1;
+}
+
+void renderViewport(void*, float, float, float) {}
+void renderCancel(void*) {}
+void renderFlush(void*) {}
+
+void renderFill(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor,
+                float fringe, const float* bounds, const NVGpath* paths, int npaths)
+{
+  NVG_NOTUSED(fringe);
+  SDLNVGcontext* sdl = (SDLNVGcontext*)uptr;
+  PaintEval pe(*paint, findTexture(sdl, paint->image));
+
+  sdl->verts.clear();
+  sdl->indices.clear();
+
+  if (npaths == 1 && paths[0].convex)
+  {
+    appendConvex(sdl, pe, paths[0].fill, paths[0].nfill);
+    if (sdl->flags & NVG_SDL_ANTIALIAS)
+      appendStrip(sdl, pe, paths[0].stroke, paths[0].nstroke, true);
+  }
+  else
+    appendScanlines(sdl, pe, bounds, paths, npaths);
+
+  submit(sdl, *paint, compositeOperation, *scissor);
+}
+
+void renderStroke(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor,
+                  float fringe, float strokeWidth, const NVGpath* paths, int npaths)
+{
+  NVG_NOTUSED(strokeWidth);
+  SDLNVGcontext* sdl = (SDLNVGcontext*)uptr;
+  PaintEval pe(*paint, findTexture(sdl, paint->image));
+
+  sdl->verts.clear();
+  sdl->indices.clear();
+  for (int i = 0; i < npaths; i++)
+  {
+    if (sdl->flags & NVG_SDL_ANTIALIAS)
+      appendStroke(sdl, pe, paths[i].stroke, paths[i].nstroke, fringe);
+    else
+      appendStrip(sdl, pe, paths[i].stroke, paths[i].nstroke, false);
+  }
+
+  submit(sdl, *paint, compositeOperation, *scissor);
+}
+
+void renderTriangles(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor,
+                     const NVGvertex* verts, int nverts)
+{
+  SDLNVGcontext* sdl = (SDLNVGcontext*)uptr;
+  SDLNVGtexture* tex = findTexture(sdl, paint->image);
+  PaintEval pe(*paint, nullptr);
+
+  sdl->verts.clear();
+  sdl->indices.clear();
+  for (int i = 0; i < nverts; i++)
+  {
+    // Text quads come with atlas coordinates already
+    SDL_Vertex v = pe.vertex(verts[i].x, verts[i].y, 1.f);
+    v.tex_coord.x = tex ? verts[i].u : 0.f;
+    v.tex_coord.y = tex ? verts[i].v : 0.f;
+    sdl->verts.push_back(v);
+    sdl->indices.push_back(i);
+  }
+
+  submit(sdl, *paint, compositeOperation, *scissor);
+}
+
+void renderDelete(void* uptr)
+{
+  SDLNVGcontext* sdl = (SDLNVGcontext*)uptr;
+  for (auto& t : sdl->textures)
+    if (t.tex)
+      SDL_DestroyTexture(t.tex);
+  delete sdl;
+}
+
+} // namespace
+
+NVGcontext *nvgCreateSDL(SDL_Renderer *renderer, int flags)
+{
+  SDLNVGcontext* sdl = new SDLNVGcontext();
+  sdl->renderer = renderer;
+  sdl->flags = flags;
+
+  NVGparams params;
+  memset(&params, 0, sizeof(params));
+  params.renderCreate = renderCreate;
+  params.renderCreateTexture = renderCreateTexture;
+  params.renderDeleteTexture = renderDeleteTexture;
+  params.renderUpdateTexture = renderUpdateTexture;
+  params.renderGetTextureSize = renderGetTextureSize;
+  params.renderViewport = renderViewport;
+  params.renderCancel = renderCancel;
+  params.renderFlush = renderFlush;
+  params.renderFill = renderFill;
+  params.renderStroke = renderStroke;
+  params.renderTriangles = renderTriangles;
+  params.renderDelete = renderDelete;
+  params.userPtr = sdl;
+  params.edgeAntiAlias = (flags & NVG_SDL_ANTIALIAS) ? 1 : 0;
+
+  // nvgCreateInternal calls renderDelete on failure
+  return nvgCreateInternal(&params);
+}
+
+void nvgDeleteSDL(NVGcontext *ctx)
+{
+  nvgDeleteInternal(ctx);
+}
+
+#else
+
+NVGcontext *nvgCreateSDL(SDL_Renderer *, int)
+{
+  return nullptr;
+}
+
+void nvgDeleteSDL(NVGcontext *) {}
+
+#endif
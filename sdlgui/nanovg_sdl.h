@@ -0,0 +1,34 @@
+/*
+    sdlgui/nanovg_sdl.h -- NanoVG back-end that draws straight into an SDL_Renderer
+
+    Paths tessellated by nanovg.c are submitted as triangle lists through
+    SDL_RenderGeometry (SDL >= 2.0.18), so no CPU rasterization is needed.
+    Paints are evaluated per vertex, which reproduces linear gradients exactly
+    and approximates box and radial gradients. Works with every SDL renderer,
+    including the software one.
+
+    Adaptation for SDL by Dalerank <dalerankn8@gmail.com>
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+/** \file */
+
+#ifndef NANOVG_SDL_H
+#define NANOVG_SDL_H
+
+#include "nanovg.h"
+
+struct SDL_Renderer;
+
+// Create flags
+enum NVGcreateFlagsSDL {
+  // Fade convex fill edges through the one pixel wide fringe generated by nanovg.c
+  NVG_SDL_ANTIALIAS = 1 << 0,
+};
+
+// Returns nullptr when SDL_RenderGeometry is not available (SDL < 2.0.18).
+NVGcontext *nvgCreateSDL(SDL_Renderer *renderer, int flags);
+void nvgDeleteSDL(NVGcontext *ctx);
+
+#endif /* NANOVG_SDL_H */
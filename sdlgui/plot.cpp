@@ -0,0 +1,284 @@
+/*
+    sdlgui/plot.cpp -- Graph that shows several series over shared axes
+
+    Based on NanoGUI by Wenzel Jakob <wenzel@inf.ethz.ch>.
+    Adaptation for SDL by Dalerank <dalerankn8@gmail.com>
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+
+#include <sdlgui/plot.h>
+#include <sdlgui/theme.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(_WIN32)
+#include <SDL.h>
+#else
+#include <SDL2/SDL.h>
+#endif
+
+NAMESPACE_BEGIN(sdlgui)
+
+namespace
+{
+  /* Straight alpha source over an ARGB8888 pixel */
+  inline void blendPixel(uint32_t& dst, const SDL_Color& c)
+  {
+    uint32_t a = c.a, ia = 255 - a;
+    uint32_t da = dst >> 24, dr = (dst >> 16) & 0xff, dg = (dst >> 8) & 0xff, db = dst & 0xff;
+    uint32_t oa = a + da * ia / 255;
+    uint32_t orr = (c.r * a + dr * ia) / 255;
+    uint32_t og = (c.g * a + dg * ia) / 255;
+    uint32_t ob = (c.b * a + db * ia) / 255;
+    dst = (oa << 24) | (orr << 16) | (og << 8) | ob;
+  }
+
+  inline void blendSpan(uint32_t* column, int pitch, int y0, int y1, const SDL_Color& c)
+  {
+    if (y0 > y1)
+      std::swap(y0, y1);
+    for (int y = y0; y <= y1; y++)
+      blendPixel(column[y * pitch], c);
+  }
+}
+
+void Plot::Series::build()
+{
+  levels.clear();
+
+  /* First level pairs raw samples, every next one pairs the buckets of the previous */
+  size_t count = values.size() / 2;
+  if (count == 0)
+    return;
+
+  levels.emplace_back(count);
+  for (size_t i = 0; i < count; i++)
+  {
+    float a = values[i * 2], b = values[i * 2 + 1];
+    levels[0][i] = { std::min(a, b), std::max(a, b), a + b };
+  }
+
+  while (levels.back().size() >= 2)
+  {
+    const std::vector<Summary>& prev = levels.back();
+    std::vector<Summary> next(prev.size() / 2);
+    for (size_t i = 0; i < next.size(); i++)
+    {
+      const Summary& a = prev[i * 2];
+      const Summary& b = prev[i * 2 + 1];
+      next[i] = { std::min(a.min, b.min), std::max(a.max, b.max), a.sum + b.sum };
+    }
+    levels.push_back(std::move(next));
+  }
+}
+
+Plot::Summary Plot::Series::summarize(size_t begin, size_t end) const
+{
+  Summary s = { std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest(), 0.f };
+
+  /* Greedy cover of [begin, end) with the largest aligned buckets that fit */
+  size_t i = begin;
+  while (i < end)
+  {
+    int level = -1;
+    for (size_t k = 0; k < levels.size(); k++)
+    {
+      size_t size = size_t(2) << k;
+      if (i % size != 0 || i + size > end || i / size >= levels[k].size())
+        break;
+      level = (int)k;
+    }
+
+    if (level < 0)
+    {
+      float v = values[i++];
+      s.min = std::min(s.min, v);
+      s.max = std::max(s.max, v);
+      s.sum += v;
+      continue;
+    }
+
+    const Summary& b = levels[level][i >> (level + 1)];
+    s.min = std::min(s.min, b.min);
+    s.max = std::max(s.max, b.max);
+    s.sum += b.sum;
+    i += size_t(2) << level;
+  }
+  return s;
+}
+
+Plot::Plot(Widget *parent, const std::string &caption)
+  : Graph(parent, caption)
+{
+}
+
+Plot::~Plot()
+{
+  if (mTexture)
+    SDL_DestroyTexture(mTexture);
+}
+
+int Plot::addSeries(const std::string &name, const Color &color)
+{
+  mSeries.emplace_back();
+  mSeries.back().name = name;
+  mSeries.back().color = color;
+  mDirty = true;
+  return (int)mSeries.size() - 1;
+}
+
+void Plot::setSeriesValues(int index, const std::vector<float> &values)
+{
+  Series& series = mSeries[index];
+  series.values = values;
+  series.build();
+  mDirty = true;
+}
+
+size_t Plot::sampleCount() const
+{
+  size_t count = 0;
+  for (const Series& s : mSeries)
+    count = std::max(count, s.values.size());
+  return count;
+}
+
+void Plot::visibleRange(double &begin, double &end) const
+{
+  begin = mViewBegin;
+  end = mViewEnd;
+  if (end <= begin)
+  {
+    begin = 0;
+    end = (double)sampleCount();
+  }
+}
+
+bool Plot::scrollEvent(const Vector2i &p, const Vector2f &rel)
+{
+  double begin, end;
+  visibleRange(begin, end);
+  if (end <= begin || width() <= 0)
+    return false;
+
+  /* Zoom around the sample under the cursor */
+  double anchor = begin + (end - begin) * (p.x - _pos.x) / (double)width();
+  double scale = std::pow(1.25, -rel.y);
+  double span = std::max((end - begin) * scale, 2.0);
+  double t = (anchor - begin) / (end - begin);
+  setView(anchor - span * t, anchor + span * (1 - t));
+  return true;
+}
+
+bool Plot::mouseDragEvent(const Vector2i &, const Vector2i &rel, int, int)
+{
+  double begin, end;
+  visibleRange(begin, end);
+  if (end <= begin || width() <= 0)
+    return false;
+
+  double shift = -rel.x * (end - begin) / width();
+  setView(begin + shift, end + shift);
+  return true;
+}
+
+void Plot::rasterize()
+{
+  int ww = mTexW, hh = mTexH;
+  SDL_Color bg = mBackgroundColor.toSdlColor();
+  uint32_t background = (uint32_t(bg.a) << 24) | (uint32_t(bg.r) << 16) | (uint32_t(bg.g) << 8) | bg.b;
+  mPixels.assign(size_t(ww) * hh, background);
+
+  /* Shared axes: quarter lines across the value range */
+  SDL_Color grid = Color(255, 24).toSdlColor();
+  for (int q = 1; q < 4; q++)
+  {
+    uint32_t* row = mPixels.data() + size_t(hh * q / 4) * ww;
+    for (int x = 0; x < ww; x++)
+      blendPixel(row[x], grid);
+  }
+
+  double begin, end;
+  visibleRange(begin, end);
+  if (end <= begin)
+    return;
+
+  double perColumn = (end - begin) / ww;
+  float yRange = mYMax - mYMin != 0.f ? mYMax - mYMin : 1.f;
+  auto toY = [&](float v) {
+    float t = 1.f - (v - mYMin) / yRange;
+    return (int)std::lround(std::min(std::max(t, 0.f), 1.f) * (hh - 1));
+  };
+
+  for (const Series& series : mSeries)
+  {
+    size_t count = series.values.size();
+    if (count == 0)
+      continue;
+
+    SDL_Color line = series.color.toSdlColor();
+    SDL_Color envelope = line;
+    envelope.a = Uint8(line.a * 0.35f);
+
+    int prevY = -1;
+    for (int x = 0; x < ww; x++)
+    {
+      double a = begin + x * perColumn;
+      double b = a + perColumn;
+      if (b <= 0)
+        continue;
+
+      size_t ia = (size_t)std::max(0.0, std::floor(a));
+      if (ia >= count)
+        break;
+      size_t ib = std::min(count, std::max(ia + 1, (size_t)std::ceil(b)));
+
+      Summary s = series.summarize(ia, ib);
+      int meanY = toY(s.sum / (ib - ia));
+      uint32_t* column = mPixels.data() + x;
+      if (ib - ia > 1)
+        blendSpan(column, ww, toY(s.max), toY(s.min), envelope);
+      blendSpan(column, ww, prevY < 0 ? meanY : prevY, meanY, line);
+      prevY = meanY;
+    }
+  }
+}
+
+void Plot::draw(SDL_Renderer *renderer)
+{
+  Widget::draw(renderer);
+
+  Vector2i ap = absolutePosition();
+  int ww = width(), hh = height();
+  if (ww > 0 && hh > 0)
+  {
+    if (!mTexture || mTexW != ww || mTexH != hh)
+    {
+      if (mTexture)
+        SDL_DestroyTexture(mTexture);
+      mTexW = ww;
+      mTexH = hh;
+      mTexture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, ww, hh);
+      SDL_SetTextureBlendMode(mTexture, SDL_BLENDMODE_BLEND);
+      mDirty = true;
+    }
+
+    if (mDirty)
+    {
+      rasterize();
+      SDL_UpdateTexture(mTexture, nullptr, mPixels.data(), ww * sizeof(uint32_t));
+      mDirty = false;
+    }
+
+    SDL_Rect dst{ ap.x, ap.y, ww, hh };
+    SDL_RenderCopy(renderer, mTexture, nullptr, &dst);
+  }
+
+  drawLabels(renderer, ap);
+}
+
+NAMESPACE_END(sdlgui)
@@ -0,0 +1,96 @@
+/*
+    sdl_gui/plot.h -- Graph that shows several series over shared axes
+
+    Based on NanoGUI by Wenzel Jakob <wenzel@inf.ethz.ch>.
+    Adaptation for SDL by Dalerank <dalerankn8@gmail.com>
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+/** \file */
+
+#pragma once
+
+#include <sdlgui/graph.h>
+
+NAMESPACE_BEGIN(sdlgui)
+
+/**
+ * \class Plot plot.h sdl_gui/plot.h
+ *
+ * \brief Draws any number of series into one texture with a shared X (sample
+ * index) and Y (value) range.
+ *
+ * Each series keeps a summary pyramid with the min, max and mean of every
+ * aligned power-of-two bucket, so a pixel column is answered from O(log n)
+ * buckets whatever the zoom level. The mouse wheel zooms around the cursor
+ * and dragging pans. Caption, header and footer work as in \ref Graph.
+ */
+class  Plot : public Graph
+{
+public:
+    Plot(Widget *parent, const std::string &caption = "Untitled");
+
+    /// Add an empty series and return its index
+    int addSeries(const std::string &name, const Color &color);
+    int seriesCount() const { return (int)mSeries.size(); }
+
+    const std::string &seriesName(int index) const { return mSeries[index].name; }
+    const Color &seriesColor(int index) const { return mSeries[index].color; }
+    void setSeriesColor(int index, const Color &color) { mSeries[index].color = color; mDirty = true; }
+
+    const std::vector<float> &seriesValues(int index) const { return mSeries[index].values; }
+    /// Replace the samples of a series and rebuild its summary pyramid
+    void setSeriesValues(int index, const std::vector<float> &values);
+
+    /// Visible value range, shared by every series
+    void setYRange(float minValue, float maxValue) { mYMin = minValue; mYMax = maxValue; mDirty = true; }
+    float yMin() const { return mYMin; }
+    float yMax() const { return mYMax; }
+
+    /// Visible sample range [begin, end); an empty range shows every sample
+    void setView(double begin, double end) { mViewBegin = begin; mViewEnd = end; mDirty = true; }
+    double viewBegin() const { return mViewBegin; }
+    double viewEnd() const { return mViewEnd; }
+    void resetView() { setView(0, 0); }
+
+    bool scrollEvent(const Vector2i &p, const Vector2f &rel) override;
+    bool mouseDragEvent(const Vector2i &p, const Vector2i &rel, int button, int modifiers) override;
+    void draw(SDL_Renderer *renderer) override;
+
+protected:
+    ~Plot();
+
+    /// Aggregate of a run of samples
+    struct Summary
+    {
+        float min, max, sum;
+    };
+
+    struct Series
+    {
+        std::string name;
+        Color color;
+        std::vector<float> values;
+        /// levels[k] holds the summaries of the aligned buckets of 2^(k+1) samples
+        std::vector<std::vector<Summary>> levels;
+
+        void build();
+        Summary summarize(size_t begin, size_t end) const;
+    };
+
+    std::vector<Series> mSeries;
+    float mYMin = 0.f, mYMax = 1.f;
+    double mViewBegin = 0, mViewEnd = 0;
+    bool mDirty = true;
+
+    std::vector<uint32_t> mPixels;
+    SDL_Texture *mTexture = nullptr;
+    int mTexW = 0, mTexH = 0;
+
+    size_t sampleCount() const;
+    void visibleRange(double &begin, double &end) const;
+    void rasterize();
+};
+
+NAMESPACE_END(sdlgui)
@@ -11,16 +11,14 @@
 
 #include <sdlgui/popup.h>
 #include <sdlgui/theme.h>
-#include <thread>
+#include <algorithm>
 
 #include "nanovg.h"
-#define NANOVG_RT_IMPLEMENTATION
-#define NANORT_IMPLEMENTATION
 #include "nanovg_rt.h"
 
 NAMESPACE_BEGIN(sdlgui)
 
-struct Popup::AsyncTexture
+struct Popup::AsyncTexture : public std::enable_shared_from_this<AsyncTexture>
 {
   int id;
   Texture tex;
@@ -30,19 +28,24 @@ struct Popup::AsyncTexture
 
   void load(Popup* ptr, int dx)
   {
-    Popup* pp = ptr;
-    AsyncTexture* self = this;
-    std::thread tgr([=]() {
-      std::lock_guard<std::mutex> guard(pp->theme()->loadMutex);
-
-      NVGcontext *ctx = nullptr;
-      int realw, realh;
-      pp->rendereBodyTexture(ctx, realw, realh, dx);
+    /* The job works on a snapshot and never touches the widget */
+    int realw, realh;
+    BodyPainter painter = ptr->bodyPainter(realw, realh, dx);
+    Theme* theme = ptr->theme();
+    std::shared_ptr<AsyncTexture> self = shared_from_this();
+    runAsync([=]() {
+      std::lock_guard<std::mutex> guard(theme->loadMutex);
+
+      NVGcontext *ctx = nvgCreateRT(NVG_DEBUG, realw, realh, 0);
+
+      float pxRatio = 1.0f;
+      nvgBeginFrame(ctx, realw, realh, pxRatio);
+      painter(ctx);
+      nvgEndFrame(ctx);
+
       self->tex.rrect = { 0, 0, realw, realh };
       self->ctx = ctx;
     });
-
-    tgr.detach();
   }
 
   void perform(SDL_Renderer* renderer)
@@ -71,53 +74,61 @@ Popup::Popup(Widget *parent, Window *parentWindow)
     : Window(parent, ""), mParentWindow(parentWindow),
       mAnchorPos(Vector2i::Zero()), mAnchorHeight(30)
 {
+  mKind |= KindPopup;
+  if (mParentWindow)
+    mParentWindow->mPopups.push_back(this);
+}
+
+Popup::~Popup()
+{
+  if (mParentWindow)
+  {
+    auto& popups = mParentWindow->mPopups;
+    popups.erase(std::remove(popups.begin(), popups.end(), this), popups.end());
+  }
 }
 
-void Popup::rendereBodyTexture(NVGcontext*& ctx, int& realw, int& realh, int dx)
+Popup::BodyPainter Popup::bodyPainter(int& realw, int& realh, int dx) const
 {
   int ww = width();
   int hh = height();
   int ds = mTheme->mWindowDropShadowSize;
+  int cr = mTheme->mWindowCornerRadius;
   int dy = 0;
+  int anchor = anchorHeight();
+  Color dropShadow = mTheme->mDropShadow;
+  Color transparent = mTheme->mTransparent;
+  Color fill = mTheme->mWindowPopup;
 
   Vector2i offset(dx + ds, dy + ds);
 
   realw = ww + 2 * ds + dx; //with + 2*shadow + offset
   realh = hh + 2 * ds + dy;
-  
-  ctx = nvgCreateRT(NVG_DEBUG, realw, realh, 0);
 
-  float pxRatio = 1.0f;
-  nvgBeginFrame(ctx, realw, realh, pxRatio);
+  return [=](NVGcontext* ctx) {
+    /* Draw a drop shadow */
+    NVGpaint shadowPaint = nvgBoxGradient(ctx, offset.x, offset.y, ww, hh, cr * 2, ds * 2,
+      dropShadow.toNvgColor(), transparent.toNvgColor());
 
-  int cr = mTheme->mWindowCornerRadius;
+    nvgBeginPath(ctx);
+    nvgRoundedRect(ctx, offset.x - ds, offset.y - ds, ww + 2 * ds, hh + 2 * ds, cr);
+    nvgFillPaint(ctx, shadowPaint);
+    nvgFill(ctx);
 
-  /* Draw a drop shadow */
-  NVGpaint shadowPaint = nvgBoxGradient(ctx, offset.x, offset.y, ww, hh, cr * 2, ds * 2,
-    mTheme->mDropShadow.toNvgColor(),
-    mTheme->mTransparent.toNvgColor());
-
-  nvgBeginPath(ctx);
-  //nvgRect(ctx, offset.x - ds, offset.y - ds, ww + 2 * ds, hh + 2 * ds);
-  nvgRoundedRect(ctx, offset.x - ds, offset.y - ds, ww + 2 * ds, hh + 2 * ds, cr);
-  //nvgPathWinding(ctx, NVG_HOLE);
-  nvgFillPaint(ctx, shadowPaint);
-  nvgFill(ctx);
-
-  /* Draw window */
-  nvgBeginPath(ctx);
-  nvgRoundedRect(ctx, offset.x, offset.y, ww, hh, cr);
-
-  Vector2i base = Vector2i(offset.x + 0, offset.y + anchorHeight());
-  int sign = -1;
-
-  nvgMoveTo(ctx, base.x + 15 * sign, base.y);
-  nvgLineTo(ctx, base.x, base.y - 15);
-  nvgLineTo(ctx, base.x, base.y + 15);
-
-  nvgFillColor(ctx, mTheme->mWindowPopup.toNvgColor());
-  nvgFill(ctx);
-  nvgEndFrame(ctx);
+    /* Draw window */
+    nvgBeginPath(ctx);
+    nvgRoundedRect(ctx, offset.x, offset.y, ww, hh, cr);
+
+    Vector2i base = Vector2i(offset.x + 0, offset.y + anchor);
+    int sign = -1;
+
+    nvgMoveTo(ctx, base.x + 15 * sign, base.y);
+    nvgLineTo(ctx, base.x, base.y - 15);
+    nvgLineTo(ctx, base.x, base.y + 15);
+
+    nvgFillColor(ctx, fill.toNvgColor());
+    nvgFill(ctx);
+  };
 }
 
 void Popup::performLayout(SDL_Renderer *ctx) 
@@ -137,7 +148,7 @@ void Popup::performLayout(SDL_Renderer *ctx)
 void Popup::refreshRelativePlacement() 
 {
     mParentWindow->refreshRelativePlacement();
-    mVisible &= mParentWindow->visibleRecursive();
+    setVisible(mVisible && mParentWindow->visibleRecursive());
 
     Widget *widget = this;
     while (widget->parent() != nullptr)
@@ -145,8 +156,10 @@ void Popup::refreshRelativePlacement()
     Screen *screen = (Screen *)widget;
     Vector2i screenSize = screen->size();
 
-    _pos = mParentWindow->position() + mAnchorPos - Vector2i(0, mAnchorHeight);
-    _pos = Vector2i(_pos.x, std::min(_pos.y, screen->size().y - mSize.y));
+    Vector2i pos = mParentWindow->position() + mAnchorPos - Vector2i(0, mAnchorHeight);
+    pos = Vector2i(pos.x, std::min(pos.y, screen->size().y - mSize.y));
+    if (pos != _pos)
+      setPosition(pos);
 }
 
 void Popup::drawBodyTemp(SDL_Renderer* renderer)
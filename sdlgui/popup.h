@@ -14,6 +14,7 @@
 
 #include <sdlgui/window.h>
 #include <sdlgui/screen.h>
+#include <functional>
 #include <vector>
 
 NAMESPACE_BEGIN(sdlgui)
@@ -28,6 +29,7 @@ NAMESPACE_BEGIN(sdlgui)
  */
 class  Popup : public Window 
 {
+    friend class Window;
 public:
     /// Create a new popup parented to a screen (first argument) and a parent window
     Popup(Widget *parent, Window *parentWindow);
@@ -56,9 +58,15 @@ public:
     virtual void drawBodyTemp(SDL_Renderer* renderer);
 
 protected:
+    /// Unregister from the parent window's popup list
+    virtual ~Popup();
+
     /// Internal helper function to maintain nested window position values
     virtual void refreshRelativePlacement();
-    virtual void rendereBodyTexture(NVGcontext* &ctx, int& ctxw, int& ctxh, int dx);
+    typedef std::function<void(NVGcontext* ctx)> BodyPainter;
+    /// Painter for the body texture of \c realw x \c realh pixels; it runs on a raster
+    /// worker, so it must capture copies of the widget state and never the widget
+    virtual BodyPainter bodyPainter(int& realw, int& realh, int dx) const;
     virtual Vector2i getOverrideBodyPos();
 
     Window *mParentWindow;
@@ -10,16 +10,13 @@
 
 #include <sdlgui/progressbar.h>
 #include <sdlgui/theme.h>
-#include <thread>
 
 #include "nanovg.h"
-#define NANOVG_RT_IMPLEMENTATION
-#define NANORT_IMPLEMENTATION
 #include "nanovg_rt.h"
 
 NAMESPACE_BEGIN(sdlgui)
 
-struct ProgressBar::AsyncTexture
+struct ProgressBar::AsyncTexture : public std::enable_shared_from_this<AsyncTexture>
 {
   Texture tex;
   NVGcontext* ctx = nullptr;
@@ -28,14 +25,14 @@ struct ProgressBar::AsyncTexture
 
   void load_body(ProgressBar* ptr)
   {
-    ProgressBar* pbar = ptr;
-    AsyncTexture* self = this;
-    std::thread tgr([=]() {
-      Theme* mTheme = pbar->theme();
+    /* The job works on a snapshot and never touches the widget */
+    Theme* mTheme = ptr->theme();
+    int ww = ptr->width();
+    int hh = ptr->height();
+    std::shared_ptr<AsyncTexture> self = shared_from_this();
+    runAsync([=]() {
       std::lock_guard<std::mutex> guard(mTheme->loadMutex);
 
-      int ww = pbar->width();
-      int hh = pbar->height();
       NVGcontext *ctx = nvgCreateRT(NVG_DEBUG, ww + 2, hh + 2, 0);
 
       float pxRatio = 1.0f;
@@ -51,32 +48,29 @@ struct ProgressBar::AsyncTexture
       self->tex.rrect = { 0, 0, ww + 2, hh + 2 };
       self->ctx = ctx;
     });
-
-    tgr.detach();
   }
 
   void load_bar(ProgressBar* ptr)
   {
-    ProgressBar* pbar = ptr;
-    AsyncTexture* self = this;
+    std::shared_ptr<AsyncTexture> self = shared_from_this();
 
     if (busy)
       return;
 
     busy = true;
 
-    std::thread tgr([=]() {
-      Theme* mTheme = pbar->theme();
+    Theme* mTheme = ptr->theme();
+    int ww = ptr->width();
+    int hh = ptr->height();
+    float value = std::min(std::max(0.0f, ptr->value()), 1.0f);
+    runAsync([=]() {
       std::lock_guard<std::mutex> guard(mTheme->loadMutex);
 
-      int ww = pbar->width();
-      int hh = pbar->height();
       NVGcontext *ctx = nvgCreateRT(NVG_DEBUG, ww + 2, hh + 2, 0);
 
       float pxRatio = 1.0f;
       nvgBeginFrame(ctx, ww + 2, hh + 2, pxRatio);
 
-      float value = std::min(std::max(0.0f, pbar->value()), 1.0f);
       int barPos = (int)std::round((ww - 2) * value);
 
       NVGpaint paint = nvgBoxGradient(
@@ -93,8 +87,6 @@ struct ProgressBar::AsyncTexture
       self->tex.rrect = { 0, 0, ww + 2, hh + 2 };
       self->ctx = ctx;
     });
-
-    tgr.detach();
   }
 
   void perform(SDL_Renderer* renderer)
@@ -16,6 +16,9 @@
 #include <sdlgui/popup.h>
 #include <iostream>
 #include <map>
+#include <algorithm>
+#include <functional>
+#include <unordered_set>
 
 #if defined(_WIN32)
 #include <SDL.h>
@@ -25,15 +28,204 @@
 
 NAMESPACE_BEGIN(sdlgui)
 
+struct Screen::GeometryMirror
+{
+  /* Window bodies and drop shadows may extend past the widget rect */
+  enum { CullMargin = 32 };
+
+  /* One entry per widget in depth-first order, which is also the draw order */
+  std::vector<Widget*> widgets;
+  std::vector<int> parents;       // -1 for the screen
+  std::vector<int> ends;          // one past the last mirrored descendant
+  std::vector<PntRect> rects;     // absolute rect
+  std::vector<PntRect> clips;     // absolute rect clipped by all ancestors
+  std::vector<PntRect> bounds;    // union of the rects of the whole subtree
+  std::vector<uint8_t> visible;   // visible together with all ancestors
+  std::vector<uint8_t> opaque;    // hit tests its own children, which are not mirrored
+  uint32_t epoch = 0;
+
+  void sync(Screen* screen)
+  {
+    if (!widgets.empty() && epoch == Widget::geometryEpoch())
+      return;
+
+    widgets.clear(); parents.clear(); ends.clear();
+    rects.clear(); clips.clear(); bounds.clear();
+    visible.clear(); opaque.clear();
+
+    Vector2i pos = screen->position();
+    PntRect rect{ pos.x, pos.y, pos.x + screen->width(), pos.y + screen->height() };
+    add(screen, -1, Vector2i::Zero(), rect, true);
+
+    PntRect view{ rect.x1 - CullMargin, rect.y1 - CullMargin, rect.x2 + CullMargin, rect.y2 + CullMargin };
+    for (size_t i = 1; i < widgets.size(); i++)
+    {
+      const PntRect& b = bounds[i];
+      widgets[i]->mCulled = !opaque[i] && !widgets[i]->isKind(Widget::KindWindow) &&
+        (b.x2 <= view.x1 || b.x1 >= view.x2 || b.y2 <= view.y1 || b.y1 >= view.y2);
+    }
+    epoch = Widget::geometryEpoch();
+  }
+
+  int add(Widget* w, int parent, const Vector2i& origin, const PntRect& pclip, bool pvisible)
+  {
+    int index = (int)widgets.size();
+    Vector2i ap = origin + w->position();
+    PntRect rect{ ap.x, ap.y, ap.x + w->width(), ap.y + w->height() };
+    PntRect clip{ std::max(pclip.x1, rect.x1), std::max(pclip.y1, rect.y1),
+                  std::min(pclip.x2, rect.x2), std::min(pclip.y2, rect.y2) };
+    bool vis = pvisible && w->visible();
+
+    widgets.push_back(w);
+    parents.push_back(parent);
+    ends.push_back(0);
+    rects.push_back(rect);
+    clips.push_back(clip);
+    bounds.push_back(rect);
+    visible.push_back(vis);
+    opaque.push_back(!w->indexableChildren());
+
+    /* Same values updateAbsoluteGeometry() would compute lazily */
+    w->mAbsPos = ap;
+    w->mAbsClip = clip;
+    w->mGeometryEpoch = Widget::geometryEpoch();
+
+    if (!opaque[index])
+    {
+      Vector2i co = ap + w->childOffset();
+      for (Widget* child : w->children())
+      {
+        int c = add(child, index, co, clip, vis);
+        PntRect& b = bounds[index];
+        const PntRect& cb = bounds[c];
+        b = PntRect{ std::min(b.x1, cb.x1), std::min(b.y1, cb.y1),
+                     std::max(b.x2, cb.x2), std::max(b.y2, cb.y2) };
+      }
+    }
+    ends[index] = (int)widgets.size();
+    return index;
+  }
+
+  static bool inside(const PntRect& r, const Vector2i& p)
+  {
+    return p.x >= r.x1 && p.y >= r.y1 && p.x < r.x2 && p.y < r.y2;
+  }
+
+  /* Same descent as Widget::findWidget: the last visible child containing p wins */
+  Widget* find(const Vector2i& p) const
+  {
+    if (widgets.empty() || !inside(rects[0], p))
+      return nullptr;
+
+    int node = 0;
+    while (true)
+    {
+      if (opaque[node])
+      {
+        int parent = parents[node];
+        Vector2i origin = parent < 0 ? Vector2i::Zero()
+          : Vector2i(rects[parent].x1, rects[parent].y1) + widgets[parent]->childOffset();
+        return widgets[node]->findWidget(p - origin);
+      }
+
+      int hit = -1;
+      for (int c = node + 1; c < ends[node]; c = ends[c])
+        if (visible[c] && inside(rects[c], p))
+          hit = c;
+      if (hit < 0)
+        return widgets[node];
+      node = hit;
+    }
+  }
+};
+
 Screen::Screen( SDL_Window* window, const Vector2i &size, const std::string &caption,
                bool resizable, bool fullscreen)
     : Widget(nullptr), _window(nullptr), mSDL_Renderer(nullptr), mCaption(caption)
 {
+    mKind |= KindScreen;
     SDL_SetWindowTitle( window, caption.c_str() );
     initialize( window );
 }
 
+Screen::Screen( SDL_Surface* surface, const std::string &caption)
+    : Widget(nullptr), _window(nullptr), mSDL_Renderer(nullptr), mCaption(caption)
+{
+    mKind |= KindScreen;
+    SDL_Renderer* renderer = surface ? SDL_CreateSoftwareRenderer(surface) : nullptr;
+    if (renderer == nullptr)
+        throw std::runtime_error("Could not create software renderer!");
+
+    mOwnsRenderer = true;
+    initialize(renderer, Vector2i(surface->w, surface->h));
+}
+
 bool Screen::onEvent(SDL_Event& event)
+{
+    if (!mBatchEvents)
+        return dispatchEvent(event);
+
+    switch( event.type )
+    {
+    case SDL_MOUSEWHEEL:
+    {
+        if (!mProcessEvents)
+            return false;
+        if (mPendingMotion)
+            flushEvents();
+        mPendingWheel = true;
+        mPendingWheelDelta += Vector2f(event.wheel.x, event.wheel.y);
+        return true;
+    }
+
+    case SDL_MOUSEMOTION:
+    {
+        if (!mProcessEvents)
+            return false;
+        if (mPendingWheel)
+            flushEvents();
+        if (mDragActive && mDragWidget && mDragWidget->wantsRawMotion())
+        {
+            flushEvents();
+            return dispatchEvent(event);
+        }
+        mPendingMotion = true;
+        mPendingMotionPos = Vector2i(event.motion.x, event.motion.y);
+        return true;
+    }
+
+    default:
+        flushEvents();
+        return dispatchEvent(event);
+    }
+}
+
+void Screen::setEventBatching(bool batching)
+{
+    if (!batching)
+        flushEvents();
+    mBatchEvents = batching;
+}
+
+bool Screen::flushEvents()
+{
+    bool ret = false;
+    if (mPendingMotion)
+    {
+        mPendingMotion = false;
+        ret |= cursorPosCallbackEvent(mPendingMotionPos.x, mPendingMotionPos.y);
+    }
+    if (mPendingWheel)
+    {
+        mPendingWheel = false;
+        Vector2f delta = mPendingWheelDelta;
+        mPendingWheelDelta = Vector2f(0, 0);
+        ret |= scrollCallbackEvent(delta.x, delta.y);
+    }
+    return ret;
+}
+
+bool Screen::dispatchEvent(SDL_Event& event)
 {
     switch( event.type )
     {
@@ -89,10 +281,18 @@ bool Screen::onEvent(SDL_Event& event)
 void Screen::initialize(SDL_Window* window)
 {
     _window = window;    
-    SDL_GetWindowSize( window, &mSize[0], &mSize[1]);
-    SDL_GetWindowSize( window, &mFBSize[0], &mFBSize[1]);
-    mSDL_Renderer = SDL_GetRenderer(window);
-    
+    Vector2i size;
+    SDL_GetWindowSize( window, &size[0], &size[1]);
+    initialize(SDL_GetRenderer(window), size);
+}
+
+void Screen::initialize(SDL_Renderer* renderer, const Vector2i &size)
+{
+    mSDL_Renderer = renderer;
+    mSize = size;
+    mFBSize = size;
+    invalidateGeometry();
+
     if (mSDL_Renderer == nullptr)
         throw std::runtime_error("Could not initialize NanoVG!");
 
@@ -108,6 +308,86 @@ void Screen::initialize(SDL_Window* window)
 
 Screen::~Screen()
 {
+    setWidgetArena(false);
+
+    /* Widgets and the theme free textures of the renderer, so they go before it does */
+    for (auto child : mChildren)
+        if (child)
+            child->decRef();
+    mChildren.clear();
+    mHoverChild = nullptr;
+    mTheme = nullptr;
+
+    if (mOwnsRenderer)
+        SDL_DestroyRenderer(mSDL_Renderer);
+}
+
+void Screen::indexIds(Widget *widget, bool add, bool recursive)
+{
+    if (!widget->mId.empty())
+    {
+        auto &entries = mIdIndex[widget->mId];
+        if (add)
+        {
+            entries.push_back(IdEntry{ widget, nullptr, nullptr });
+        }
+        else
+        {
+            entries.erase(std::remove_if(entries.begin(), entries.end(),
+                [widget](const IdEntry &e) { return e.widget == widget; }), entries.end());
+            if (entries.empty())
+                mIdIndex.erase(widget->mId);
+        }
+    }
+
+    if (recursive)
+        for (auto child : widget->mChildren)
+            indexIds(child, add, true);
+}
+
+void Screen::setGeometryMirror(bool enabled)
+{
+    if (enabled == geometryMirror())
+        return;
+
+    mGeometryMirror = enabled ? std::make_shared<GeometryMirror>() : nullptr;
+    if (!enabled)
+    {
+        /* Forget the culling decisions of the last pass */
+        std::vector<Widget *> stack(mChildren.begin(), mChildren.end());
+        while (!stack.empty())
+        {
+            Widget *w = stack.back();
+            stack.pop_back();
+            w->mCulled = false;
+            stack.insert(stack.end(), w->children().begin(), w->children().end());
+        }
+    }
+}
+
+Widget *Screen::findWidget(const Vector2i &p)
+{
+    if (!mGeometryMirror)
+        return Widget::findWidget(p);
+
+    mGeometryMirror->sync(this);
+    return mGeometryMirror->find(p);
+}
+
+void Screen::setWidgetArena(bool enabled)
+{
+    if (enabled == (mArena != nullptr))
+        return;
+
+    if (enabled)
+    {
+        mArena = WidgetArena::create();
+    }
+    else
+    {
+        mArena->release();
+        mArena = nullptr;
+    }
 }
 
 void Screen::setVisible(bool visible)
@@ -116,6 +396,9 @@ void Screen::setVisible(bool visible)
      {
         mVisible = visible;
 
+        if (!_window)
+            return;
+
         if (visible)
             SDL_ShowWindow(_window);
         else
@@ -127,7 +410,8 @@ void Screen::setCaption(const std::string &caption)
 {
     if (caption != mCaption)
     {
-        SDL_SetWindowTitle( _window, caption.c_str());
+        if (_window)
+            SDL_SetWindowTitle( _window, caption.c_str());
         mCaption = caption;
     }
 }
@@ -135,15 +419,67 @@ void Screen::setCaption(const std::string &caption)
 void Screen::setSize(const Vector2i &size)
 {
     Widget::setSize(size);
-    SDL_SetWindowSize(_window, size.x, size.y);
+    if (_window)
+        SDL_SetWindowSize(_window, size.x, size.y);
 }
 
 void Screen::drawAll()
 {
+  flushEvents();
   drawContents();
   drawWidgets();
 }
 
+bool Screen::flushAsyncTextures(int maxPasses)
+{
+  for (int pass = 0; pass < maxPasses; pass++)
+  {
+    waitAsyncJobs();
+    uint64_t started = asyncJobsStarted();
+
+    SDL_Color bg = mBackground.toSdlColor();
+    SDL_SetRenderDrawColor(mSDL_Renderer, bg.r, bg.g, bg.b, bg.a);
+    SDL_RenderClear(mSDL_Renderer);
+    drawAll();
+
+    /* Every texture was ready before the frame and none was requested by it */
+    if (asyncJobsStarted() == started)
+      return true;
+  }
+
+  waitAsyncJobs();
+  return false;
+}
+
+SDL_Surface* Screen::captureFrame()
+{
+  int w, h;
+  if (SDL_GetRendererOutputSize(mSDL_Renderer, &w, &h) != 0)
+    return nullptr;
+
+  SDL_Surface* frame = SDL_CreateRGBSurfaceWithFormat(0, w, h, 32, SDL_PIXELFORMAT_ABGR8888);
+  if (!frame)
+    return nullptr;
+
+  if (SDL_RenderReadPixels(mSDL_Renderer, nullptr, SDL_PIXELFORMAT_ABGR8888, frame->pixels, frame->pitch) != 0)
+  {
+    SDL_FreeSurface(frame);
+    return nullptr;
+  }
+  return frame;
+}
+
+bool Screen::dumpFrame(const std::string& filename)
+{
+  SDL_Surface* frame = captureFrame();
+  if (!frame)
+    return false;
+
+  bool ok = SDL_SaveBMP(frame, filename.c_str()) == 0;
+  SDL_FreeSurface(frame);
+  return ok;
+}
+
 void Screen::drawWidgets()
 {
     if (!mVisible)
@@ -152,7 +488,9 @@ void Screen::drawWidgets()
     /* Calculate pixel ratio for hi-dpi devices. */
     mPixelRatio = (float) mFBSize[0] / (float) mSize[0];
     
-    SDL_Renderer* renderer = SDL_GetRenderer(_window);
+    SDL_Renderer* renderer = mSDL_Renderer;
+    if (mGeometryMirror)
+        mGeometryMirror->sync(this);
     draw(renderer);
 
     double elapsed = SDL_GetTicks() - mLastInteraction;
@@ -224,8 +562,9 @@ bool Screen::cursorPosCallbackEvent(double x, double y)
 
         if (!mDragActive) 
         {
+            /* Cursor shapes are not supported yet, so no hit test is needed here
             Widget *widget = findWidget(p);
-            /*if (widget != nullptr && widget->cursor() != mCursor) {
+            if (widget != nullptr && widget->cursor() != mCursor) {
                 mCursor = widget->cursor();
                 glfwSetCursor(mGLFWWindow, mCursors[(int) mCursor]);
             }*/
@@ -237,6 +576,7 @@ bool Screen::cursorPosCallbackEvent(double x, double y)
                 mMouseState, mModifiers);
         }
 
+        updateHover(p);
         if (!ret)
             ret = mouseMotionEvent(p, p - mMousePos, mMouseState, mModifiers);
 
@@ -256,8 +596,9 @@ bool Screen::mouseButtonCallbackEvent(int button, int action, int modifiers) {
     mLastInteraction = SDL_GetTicks();
     try {
         if (mFocusPath.size() > 1) {
-            const Window *window =
-                dynamic_cast<Window *>(mFocusPath[mFocusPath.size() - 2]);
+            const Widget *top = mFocusPath[mFocusPath.size() - 2];
+            const Window *window = top->isKind(KindWindow)
+                ? static_cast<const Window *>(top) : nullptr;
             if (window && window->modal()) {
                 if (!window->contains(mMousePos))
                     return false;
@@ -269,7 +610,10 @@ bool Screen::mouseButtonCallbackEvent(int button, int action, int modifiers) {
         else
             mMouseState &= ~(1 << button);
 
-        auto dropWidget = findWidget(mMousePos);
+        /* One hit test serves both the drop target and the new drag widget */
+        Widget *hitWidget = findWidget(mMousePos);
+
+        auto dropWidget = hitWidget;
         if (mDragActive && action == SDL_MOUSEBUTTONUP &&
             dropWidget != mDragWidget)
             mDragWidget->mouseButtonEvent(
@@ -282,7 +626,7 @@ bool Screen::mouseButtonCallbackEvent(int button, int action, int modifiers) {
         }*/
 
         if (action == SDL_MOUSEBUTTONDOWN && button == SDL_BUTTON_LEFT) {
-            mDragWidget = findWidget(mMousePos);
+            mDragWidget = hitWidget;
             if (mDragWidget == this)
                 mDragWidget = nullptr;
             mDragActive = mDragWidget != nullptr;
@@ -338,8 +682,9 @@ bool Screen::scrollCallbackEvent(double x, double y)
     mLastInteraction = SDL_GetTicks();
     try {
         if (mFocusPath.size() > 1) {
-            const Window *window =
-                dynamic_cast<Window *>(mFocusPath[mFocusPath.size() - 2]);
+            const Widget *top = mFocusPath[mFocusPath.size() - 2];
+            const Window *window = top->isKind(KindWindow)
+                ? static_cast<const Window *>(top) : nullptr;
             if (window && window->modal()) {
                 if (!window->contains(mMousePos))
                     return false;
@@ -359,13 +704,18 @@ bool Screen::resizeCallbackEvent(int, int)
 {
   Vector2i fbSize, size;
     //glfwGetFramebufferSize(mGLFWWindow, &fbSize[0], &fbSize[1]);
-    SDL_GetWindowSize(_window, &size[0], &size[1]);
+    if (_window)
+        SDL_GetWindowSize(_window, &size[0], &size[1]);
+    else
+        SDL_GetRendererOutputSize(mSDL_Renderer, &size[0], &size[1]);
+    fbSize = size;
 
     if (mFBSize == Vector2i(0, 0) || size == Vector2i(0, 0))
         return false;
 
     mFBSize = fbSize;
     mSize = size;
+    invalidateGeometry();
     mLastInteraction = SDL_GetTicks();
 
     try 
@@ -390,7 +740,7 @@ void Screen::updateFocus(Widget *widget) {
     Widget *window = nullptr;
     while (widget) {
         mFocusPath.push_back(widget);
-        if (dynamic_cast<Window *>(widget))
+        if (widget->isKind(KindWindow))
             window = widget;
         widget = widget->parent();
     }
@@ -401,6 +751,46 @@ void Screen::updateFocus(Widget *widget) {
         moveWindowToFront((Window *) window);
 }
 
+void Screen::updateHover(const Vector2i &p)
+{
+    /* The old path may end in widgets that were removed in the meantime:
+       removeChild() unlinks mHoverChild, so keep only the linked prefix */
+    size_t alive = mHoverPath.empty() ? 0 : 1;
+    while (alive < mHoverPath.size() && mHoverPath[alive - 1]->mHoverChild == mHoverPath[alive])
+        ++alive;
+    mHoverPath.resize(alive);
+
+    mHoverScratch.clear();
+    for (Widget *w = findWidget(p); w; w = w->parent())
+        mHoverScratch.push_back(w);
+    std::reverse(mHoverScratch.begin(), mHoverScratch.end());
+
+    size_t common = 0;
+    while (common < mHoverPath.size() && common < mHoverScratch.size() &&
+           mHoverPath[common] == mHoverScratch[common])
+        ++common;
+
+    /* Leave events go from the innermost widget outwards, enter events inwards.
+       The screen itself never receives them */
+    for (size_t i = mHoverPath.size(); i-- > std::max(common, (size_t) 1);)
+    {
+        Widget *w = mHoverPath[i];
+        w->mouseEnterEvent(p - w->parent()->absolutePosition(), false);
+    }
+    for (Widget *w : mHoverPath)
+        w->mHoverChild = nullptr;
+
+    for (size_t i = std::max(common, (size_t) 1); i < mHoverScratch.size(); ++i)
+    {
+        Widget *w = mHoverScratch[i];
+        w->mouseEnterEvent(p - w->parent()->absolutePosition(), true);
+    }
+    for (size_t i = 0; i + 1 < mHoverScratch.size(); ++i)
+        mHoverScratch[i]->mHoverChild = mHoverScratch[i + 1];
+
+    mHoverPath.swap(mHoverScratch);
+}
+
 void Screen::disposeWindow(Window *window) {
     if (std::find(mFocusPath.begin(), mFocusPath.end(), window) != mFocusPath.end())
         mFocusPath.clear();
@@ -420,25 +810,31 @@ void Screen::centerWindow(Window *window)
 }
 
 void Screen::moveWindowToFront(Window *window) {
-    mChildren.erase(std::remove(mChildren.begin(), mChildren.end(), window), mChildren.end());
-    mChildren.push_back(window);
-    /* Brute force topological sort (no problem for a few windows..) */
-    bool changed = false;
-    do {
-        size_t baseIndex = 0;
-        for (size_t index = 0; index < mChildren.size(); ++index)
-            if (mChildren[index] == window)
-                baseIndex = index;
-        changed = false;
-        for (size_t index = 0; index < mChildren.size(); ++index) {
-            Popup *pw = dynamic_cast<Popup *>(mChildren[index]);
-            if (pw && pw->parentWindow() == window && index < baseIndex) {
-                moveWindowToFront(pw);
-                changed = true;
-                break;
-            }
-        }
-    } while (changed);
+    /* The window and, recursively, the popups anchored to it form one block
+       that keeps its internal order and moves above all other children */
+    std::vector<Widget *> block;
+    std::unordered_set<const Widget *> members;
+    /* Depth first: each window is followed by its popups, in creation order */
+    std::function<void(Window *)> append = [&](Window *w) {
+        if (w->parent() != this || !members.insert(w).second)
+            return;
+        block.push_back(w);
+        for (Popup *popup : w->popups())
+            append(popup);
+    };
+    append(window);
+    if (block.empty())
+        return;
+
+    size_t count = 0;
+    for (Widget *child : mChildren)
+        if (!members.count(child))
+            mChildren[count++] = child;
+    mChildren.resize(count);
+    mChildren.insert(mChildren.end(), block.begin(), block.end());
+
+    /* The draw order changed, which the geometry mirror depends on */
+    invalidateGeometry();
 }
 
 void Screen::performLayout(SDL_Renderer* ctx)
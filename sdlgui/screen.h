@@ -17,6 +17,7 @@
 
 union SDL_Event;
 struct SDL_Window;
+struct SDL_Surface;
 
 NAMESPACE_BEGIN(sdlgui)
 
@@ -33,6 +34,15 @@ public:
     Screen( SDL_Window* window, const Vector2i &size, const std::string &caption,
             bool resizable = true, bool fullscreen = false);
 
+    /**
+     * \brief Create an offscreen screen that draws into \c surface.
+     *
+     * No window or display is needed: a software renderer is created on the
+     * surface and owned by the screen. Meant for benchmarks and golden image
+     * tests together with \ref flushAsyncTextures and \ref dumpFrame.
+     */
+    Screen( SDL_Surface* surface, const std::string &caption = "");
+
     /// Release all resources
     virtual ~Screen();
 
@@ -59,6 +69,50 @@ public:
 
     virtual bool onEvent(SDL_Event& event);
 
+    /**
+     * \brief Coalesce mouse motion and wheel events until the next frame.
+     *
+     * While enabled, runs of consecutive \c SDL_MOUSEMOTION events passed to
+     * \ref onEvent collapse into the last cursor position and runs of
+     * \c SDL_MOUSEWHEEL events into one summed delta. The batch is dispatched
+     * before any other event and at the start of \ref drawAll, so widgets see
+     * one motion and one scroll per frame. Motion is never batched while the
+     * dragged widget asks for \ref Widget::wantsRawMotion.
+     */
+    void setEventBatching(bool batching);
+    bool eventBatching() const { return mBatchEvents; }
+
+    /// Dispatch the motion and wheel events collected by event batching
+    bool flushEvents();
+
+    /**
+     * \brief Allocate the widgets built under this screen from a slab arena.
+     *
+     * Widgets added under this screen with \ref Widget::wdg, and the widgets
+     * their constructors create, come from the screen's own arena, so several
+     * screens can each keep one. Its slabs are freed together once the last
+     * widget built from it is destroyed, see \ref WidgetArena.
+     */
+    void setWidgetArena(bool enabled);
+    /// Return the arena enabled with \ref setWidgetArena, if any
+    WidgetArena *widgetArena() const { return mArena; }
+
+    /**
+     * \brief Keep a flattened copy of the widget geometry for per-frame passes.
+     *
+     * The mirror stores the tree in depth-first (draw) order as parallel
+     * arrays: parent index, subtree end, absolute rect, clip rect and
+     * effective visibility. It is rebuilt in one pass whenever the geometry
+     * epoch changes; the pass also refreshes every widget's absolute position
+     * cache, drives \ref findWidget and marks subtrees that are entirely off
+     * screen as culled so that \ref draw skips them.
+     */
+    void setGeometryMirror(bool enabled);
+    bool geometryMirror() const { return mGeometryMirror != nullptr; }
+
+    /// Find the widget under \c p, using the geometry mirror when enabled
+    Widget *findWidget(const Vector2i &p) override;
+
     /// Draw the window contents -- put your OpenGL draw calls here
     virtual void drawContents() { /* To be overridden */ }
 
@@ -76,6 +130,21 @@ public:
 
     virtual void drawAll();
 
+    /**
+     * \brief Draw frames until no widget waits for a worker thread texture.
+     *
+     * Each pass clears to the background color, draws all widgets and then
+     * waits for the raster jobs that the frame started. Returns false when
+     * textures were still requested after \c maxPasses frames.
+     */
+    bool flushAsyncTextures(int maxPasses = 8);
+
+    /// Read back the current frame as a new ABGR8888 surface (free with SDL_FreeSurface)
+    SDL_Surface* captureFrame();
+
+    /// Save the current frame as a BMP file
+    bool dumpFrame(const std::string& filename);
+
     /// Return the last observed mouse position value
     Vector2i mousePos() const { return mMousePos; }
 
@@ -92,6 +161,8 @@ public:
 public:
     /// Initialize the \ref Screen
     void initialize(SDL_Window *window);
+    /// Initialize the \ref Screen without a window
+    void initialize(SDL_Renderer *renderer, const Vector2i &size);
 
     /* Event handlers */
     bool cursorPosCallbackEvent(double x, double y);
@@ -103,7 +174,9 @@ public:
     bool resizeCallbackEvent(int width, int height);
 
     /* Internal helper functions */
+    bool dispatchEvent(SDL_Event& event);
     void updateFocus(Widget *widget);
+    void updateHover(const Vector2i &p);
     void disposeWindow(Window *window);
     void centerWindow(Window *window);
     void moveWindowToFront(Window *window);
@@ -111,15 +184,37 @@ public:
 
     void performLayout(SDL_Renderer *renderer);
 
+    /// Add or remove the id of \c widget (and of its whole subtree if \c recursive) in the id index
+    void indexIds(Widget *widget, bool add, bool recursive);
+
 protected:
     SDL_Window *_window;
     std::vector<Widget *> mFocusPath;
+    std::vector<Widget *> mHoverPath, mHoverScratch; /* root first */
     SDL_Renderer* mSDL_Renderer;
+    bool mOwnsRenderer = false;
     Vector2i mFBSize;
     float mPixelRatio;
     int mMouseState, mModifiers;
     Vector2i mMousePos;
     bool mDragActive;
+    bool mBatchEvents = false;
+    bool mPendingMotion = false, mPendingWheel = false;
+    Vector2i mPendingMotionPos;
+    Vector2f mPendingWheelDelta;
+    WidgetArena *mArena = nullptr;
+
+    /* id -> widgets carrying it, in registration order; the typed gfind<T> result is cached per entry */
+    struct IdEntry
+    {
+        Widget *widget;
+        const std::type_info *castType;
+        void *cast;
+    };
+    std::unordered_map<std::string, std::vector<IdEntry>> mIdIndex;
+
+    struct GeometryMirror;
+    std::shared_ptr<GeometryMirror> mGeometryMirror;
     Widget *mDragWidget = nullptr;
     double mLastInteraction;
     bool mProcessEvents;
@@ -33,4 +33,5 @@
 #include <sdl_gui/vscrollpanel.h>
 #include <sdl_gui/colorwheel.h>
 #include <sdl_gui/graph.h>
+#include <sdl_gui/plot.h>
 #include <sdl_gui/formhelper.h>
@@ -12,39 +12,36 @@
 #include <sdlgui/theme.h>
 #include <sdlgui/entypo.h>
 #include <array>
-#include <thread>
 
 #include "nanovg.h"
-#define NANOVG_RT_IMPLEMENTATION
-#define NANORT_IMPLEMENTATION
 #include "nanovg_rt.h"
 
 NAMESPACE_BEGIN(sdlgui)
 
-struct Slider::AsyncTexture
+struct Slider::AsyncTexture : public std::enable_shared_from_this<AsyncTexture>
 {
   Texture tex;
   NVGcontext* ctx = nullptr;
 
   void load_body(Slider* ptr, bool enabled)
   {
-    Slider* slider = ptr;
-    AsyncTexture* self = this;
-    std::thread tgr([=]() {
-      Theme* mTheme = slider->theme();
+    /* The job works on a snapshot and never touches the widget */
+    Theme* mTheme = ptr->theme();
+    int ww = ptr->width();
+    int hh = ptr->height();
+    auto mHighlightedRange = ptr->highlightedRange();
+    Color highlightColor = ptr->highlightColor();
+    std::shared_ptr<AsyncTexture> self = shared_from_this();
+    runAsync([=]() {
       std::lock_guard<std::mutex> guard(mTheme->loadMutex);
 
-      int ww = slider->width();
-      int hh = slider->height();
       int rh = hh / 3;
-      auto mRange = slider->range();
-      auto mHighlightedRange = slider->highlightedRange();
       NVGcontext *ctx = nvgCreateRT(NVG_DEBUG, ww, hh, 0);
 
       float pxRatio = 1.0f;
       nvgBeginFrame(ctx, ww, hh, pxRatio);
 
-      Vector2f center = slider->size().cast<float>() * 0.5f;
+      Vector2f center = Vector2i(ww, hh).cast<float>() * 0.5f;
       int rectround = hh / 2;
       float kr = (int)(hh * 0.4f), kshadow = 3;
 
@@ -67,7 +64,7 @@ struct Slider::AsyncTexture
           center.y - kshadow + 1,
           widthX *  (mHighlightedRange.second - mHighlightedRange.first),
           kshadow * 2, 2);
-        nvgFillColor(ctx, slider->highlightColor().toNvgColor());
+        nvgFillColor(ctx, highlightColor.toNvgColor());
         nvgFill(ctx);
       }
 
@@ -75,25 +72,19 @@ struct Slider::AsyncTexture
       self->tex.rrect = { 0, 0, ww, hh };
       self->ctx = ctx;
     });
-
-    tgr.detach();
   }
 
   void load_knob(Slider* ptr, bool enabled)
   {
-    Slider* slider = ptr;
-    AsyncTexture* self = this;
+    Theme* mTheme = ptr->theme();
+    int hh = ptr->height();
+    std::shared_ptr<AsyncTexture> self = shared_from_this();
 
-    std::thread tgr([=]() {
-      Theme* mTheme = slider->theme();
+    runAsync([=]() {
       std::lock_guard<std::mutex> guard(mTheme->loadMutex);
 
-      int hh = slider->height();
       int ww = hh;
 
-      auto mRange = slider->range();
-      float mValue = slider->value();
-
       NVGcontext *ctx = nvgCreateRT(NVG_DEBUG, ww, hh, 0);
 
       float pxRatio = 1.0f;
@@ -141,8 +132,6 @@ struct Slider::AsyncTexture
       self->tex.rrect = { 0, 0, ww, hh };
       self->ctx = ctx;
     });
-
-    tgr.detach();
   }
 
   void perform(SDL_Renderer* renderer)
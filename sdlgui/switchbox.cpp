@@ -10,16 +10,13 @@
 
 #include <sdlgui/switchbox.h>
 #include <sdlgui/theme.h>
-#include <thread>
 
 #include "nanovg.h"
-#define NANOVG_RT_IMPLEMENTATION
-#define NANORT_IMPLEMENTATION
 #include "nanovg_rt.h"
 
 NAMESPACE_BEGIN(sdlgui)
 
-struct SwitchBox::AsyncTexture
+struct SwitchBox::AsyncTexture : public std::enable_shared_from_this<AsyncTexture>
 {
   int id;
   Texture tex;
@@ -29,21 +26,20 @@ struct SwitchBox::AsyncTexture
 
   void load_body(SwitchBox* ptr, bool enabled)
   {
-    SwitchBox* sb = ptr;
-    AsyncTexture* self = this;
-    std::thread tgr([=]() {
-      Theme* theme = sb->theme();
-
-      int ww = sb->width();
-      int hh = sb->height();
+    /* The job works on a snapshot and never touches the widget */
+    Theme* theme = ptr->theme();
+    int ww = ptr->width();
+    int hh = ptr->height();
+    bool horizontal = ptr->mAlign == Alignment::Horizontal;
+    std::shared_ptr<AsyncTexture> self = shared_from_this();
+    runAsync([=]() {
       NVGcontext *ctx = nvgCreateRT(NVG_DEBUG, ww, hh, 0);
 
       float pxRatio = 1.0f;
       nvgBeginFrame(ctx, ww, hh, pxRatio);
 
-      Vector2f center = sb->size().cast<float>() * 0.5f;
       float kr, startX, startY, widthX, heightY;
-      if (sb->mAlign == Alignment::Horizontal)
+      if (horizontal)
       {
         kr = hh * 0.4f;
         startX = hh * 0.1f;
@@ -87,18 +83,14 @@ struct SwitchBox::AsyncTexture
       self->tex.rrect = { 0, 0, ww, hh };
       self->ctx = ctx;
     });
-
-    tgr.detach();
   }
 
   void load_knob(SwitchBox* ptr, bool enabled)
   {
-    SwitchBox* sb = ptr;
-    AsyncTexture* self = this;
-    std::thread tgr([=]() {
-      Theme* theme = sb->theme();
-
-      int ww = std::min(sb->width(), sb->height());
+    Theme* theme = ptr->theme();
+    int ww = std::min(ptr->width(), ptr->height());
+    std::shared_ptr<AsyncTexture> self = shared_from_this();
+    runAsync([=]() {
       int hh = ww;
 
       Vector2f center(ww/2, hh/2);
@@ -132,8 +124,6 @@ struct SwitchBox::AsyncTexture
       self->tex.rrect = { 0, 0, ww, ww };
       self->ctx = ctx;
     });
-
-    tgr.detach();
   }
 
   void perform(SDL_Renderer* renderer)
@@ -23,108 +23,11 @@
 #endif
 #include <regex>
 #include <iostream>
-#include <thread>
 
 #include "nanovg.h"
-#define NANOVG_RT_IMPLEMENTATION
-#define NANORT_IMPLEMENTATION
-#include "nanovg_rt.h"
 
 NAMESPACE_BEGIN(sdlgui)
 
-struct TextBox::AsyncTexture
-{
-  int id;
-  Texture tex;
-  NVGcontext* ctx = nullptr;
-  float value = -1;
-
-  AsyncTexture(int _id) : id(_id) {}
-
-  void load(TextBox* ptr, bool editable, bool focused, bool validFormat, bool outside)
-  {
-    TextBox* tbox = ptr;
-    AsyncTexture* self = this;
-    std::thread tgr([=]() {
-      Theme* mTheme = tbox->theme();
-      std::lock_guard<std::mutex> guard(mTheme->loadMutex);
-
-      int ww = tbox->width();
-      int hh = tbox->height();
-      int realw = ww + 2;
-      int realh = hh + 2;
-      int dx = 1, dy = 1;
-      NVGcontext *ctx = nvgCreateRT(NVG_DEBUG, realw, realh + 2, 0);
-
-      float pxRatio = 1.0f;
-      nvgBeginFrame(ctx, realw, realh, pxRatio);
-
-      NVGpaint bg = nvgBoxGradient(ctx, dx + 1, dy + 1 + 1.0f, ww - 2, hh - 2,
-        3, 4, Color(255, 128).toNvgColor(), Color(32, 32).toNvgColor());
-      NVGpaint fg1 = nvgBoxGradient(ctx, dx + 1, dy + 1 + 1.0f, ww - 2, hh - 2,
-        3, 4, Color(150, 32).toNvgColor(), Color(32, 32).toNvgColor());
-      NVGpaint fg2 = nvgBoxGradient(ctx, dx + 1, dy + 1 + 1.0f, ww - 2, hh - 2,
-        3, 4, nvgRGBA(255, 0, 0, 100), nvgRGBA(255, 0, 0, 50));
-
-      nvgBeginPath(ctx);
-      nvgRoundedRect(ctx, dx + 1, dy + 1 + 1.0f, ww - 2, hh - 2, 3);
-
-      if (editable && focused)
-      {
-        validFormat 
-            ? nvgFillPaint(ctx, fg1) 
-            : nvgFillPaint(ctx, fg2);
-      }
-      else if (outside)
-        nvgFillPaint(ctx, fg1);
-      else
-        nvgFillPaint(ctx, bg);
-
-      nvgFill(ctx);
-
-      nvgBeginPath(ctx);
-      nvgRoundedRect(ctx, dx + 0.5f, dy + 0.5f, ww - 1, hh - 1, 2.5f);
-      nvgStrokeColor(ctx, Color(0, 48).toNvgColor());
-      nvgStroke(ctx);
-
-      nvgEndFrame(ctx);
-      self->tex.rrect = { 0, 0, realw, realh };
-      self->ctx = ctx;
-    });
-
-    tgr.detach();
-  }
-
-  void perform(SDL_Renderer* renderer)
-  {
-    if (!ctx)
-      return;
-
-    unsigned char *rgba = nvgReadPixelsRT(ctx);
-
-    if (tex.tex)
-    {
-      int w, h;
-      SDL_QueryTexture(tex.tex, nullptr, nullptr, &w, &h);
-      if (w != tex.w() || h != tex.h())
-        SDL_DestroyTexture(tex.tex);
-    }
-
-    if (!tex.tex)
-      tex.tex = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ABGR8888, SDL_TEXTUREACCESS_STREAMING, tex.w(), tex.h());
-
-    int pitch;
-    uint8_t *pixels;
-    int ok = SDL_LockTexture(tex.tex, nullptr, (void **)&pixels, &pitch);
-    memcpy(pixels, rgba, sizeof(uint32_t) * tex.w() * tex.h());
-    SDL_SetTextureBlendMode(tex.tex, SDL_BLENDMODE_BLEND);
-    SDL_UnlockTexture(tex.tex);
-
-    nvgDeleteRT(ctx);
-    ctx = nullptr;
-  }
-};
-
 TextBox::TextBox(Widget *parent,const std::string &value, const std::string& units)
     : Widget(parent),
       mEditable(false),
@@ -198,23 +101,79 @@ Vector2i TextBox::preferredSize(SDL_Renderer *ctx) const
 void TextBox::drawBody(SDL_Renderer* renderer)
 {
   bool outside = mSpinnable && mMouseDownPos.x != -1;
-  int id = (mEditable ? 0x1 : 0)
-    + (focused() ? 0x2 : 0)
-    + (mValidFormat ? 0x4 : 0)
+  bool editable = mEditable, focus = focused(), validFormat = mValidFormat;
+  int id = (editable ? 0x1 : 0)
+    + (focus ? 0x2 : 0)
+    + (validFormat ? 0x4 : 0)
     + (outside ? 0x8 : 0);
 
-  auto atx = std::find_if(_txs.begin(), _txs.end(), [id](AsyncTexturePtr const& p) { return p->id == id; });
+  auto painter = [=](NVGcontext* ctx, int realw, int realh)
+    {
+      int ww = realw - 2;
+      int hh = realh - 2;
+      int dx = 1, dy = 1;
+
+      NVGpaint bg = nvgBoxGradient(ctx, dx + 1, dy + 1 + 1.0f, ww - 2, hh - 2,
+        3, 4, Color(255, 128).toNvgColor(), Color(32, 32).toNvgColor());
+      NVGpaint fg1 = nvgBoxGradient(ctx, dx + 1, dy + 1 + 1.0f, ww - 2, hh - 2,
+        3, 4, Color(150, 32).toNvgColor(), Color(32, 32).toNvgColor());
+      NVGpaint fg2 = nvgBoxGradient(ctx, dx + 1, dy + 1 + 1.0f, ww - 2, hh - 2,
+        3, 4, nvgRGBA(255, 0, 0, 100), nvgRGBA(255, 0, 0, 50));
+
+      nvgBeginPath(ctx);
+      nvgRoundedRect(ctx, dx + 1, dy + 1 + 1.0f, ww - 2, hh - 2, 3);
+
+      if (editable && focus)
+      {
+        validFormat
+            ? nvgFillPaint(ctx, fg1)
+            : nvgFillPaint(ctx, fg2);
+      }
+      else if (outside)
+        nvgFillPaint(ctx, fg1);
+      else
+        nvgFillPaint(ctx, bg);
+
+      nvgFill(ctx);
 
-  if (atx != _txs.end())
-    drawTexture(*atx, renderer);
+      nvgBeginPath(ctx);
+      nvgRoundedRect(ctx, dx + 0.5f, dy + 0.5f, ww - 1, hh - 1, 2.5f);
+      nvgStrokeColor(ctx, Color(0, 48).toNvgColor());
+      nvgStroke(ctx);
+    };
+
+  Vector2i ap = absolutePosition();
+  if (mGeometryBody && mTheme->paintGeometry(renderer, ap, size() + Vector2i(2, 2), painter))
+    return;
+
+  const NinePatch* skin = mTheme->getSkin(renderer, Theme::SkinClass::TextBox, id,
+                                          Vector2i(20, 20), PntRect{ 8, 8, 8, 8 }, painter);
+  if (skin && skin->tex.tex)
+    SDL_RenderCopy(renderer, *skin, SDL_Rect{ ap.x, ap.y, width() + 2, height() + 2 });
   else
-  {
-    AsyncTexturePtr newtx = std::make_shared<AsyncTexture>(id);
-    newtx->load(this, mEditable, focused(), mValidFormat, outside);
-    _txs.push_back(newtx);
+    drawBodyTemp(renderer);
+}
+
+void TextBox::drawBodyTemp(SDL_Renderer* renderer)
+{
+  Vector2i ap = absolutePosition();
+  bool outside = mSpinnable && mMouseDownPos.x != -1;
 
-    drawTexture(current_texture_, renderer);
-  }
+  /* Flat version of the skin: the inner gradient color, then the outline */
+  SDL_Color fill = Color(255, 128).toSdlColor();
+  if (mEditable && focused())
+    fill = mValidFormat ? Color(150, 32).toSdlColor() : SDL_Color{ 255, 0, 0, 100 };
+  else if (outside)
+    fill = Color(150, 32).toSdlColor();
+
+  SDL_Rect bodyRect{ ap.x + 2, ap.y + 3, width() - 2, height() - 2 };
+  SDL_SetRenderDrawColor(renderer, fill.r, fill.g, fill.b, fill.a);
+  SDL_RenderFillRect(renderer, &bodyRect);
+
+  SDL_Color border = Color(0, 48).toSdlColor();
+  SDL_Rect borderRect{ ap.x + 1, ap.y + 1, width(), height() };
+  SDL_SetRenderDrawColor(renderer, border.r, border.g, border.b, border.a);
+  SDL_RenderDrawRect(renderer, &borderRect);
 }
 
 void TextBox::draw(SDL_Renderer* renderer) 
@@ -830,26 +789,5 @@ TextBox::SpinArea TextBox::spinArea(const Vector2i & pos)
     return SpinArea::None;
 }
 
-
-void TextBox::drawTexture(AsyncTexturePtr& texture, SDL_Renderer* renderer)
-{
-  if (texture)
-  {
-    texture->perform(renderer);
-
-    if (texture->tex.tex)
-    {
-      SDL_RenderCopy(renderer, texture->tex, absolutePosition());
-
-      if (!current_texture_ || texture->id != current_texture_->id)
-        current_texture_ = texture;
-    }
-    else if (current_texture_)
-    {
-      SDL_RenderCopy(renderer, current_texture_->tex, absolutePosition());
-    }
-  }
-}
-
 NAMESPACE_END(sdlgui)
 
@@ -83,6 +83,8 @@ public:
     Vector2i preferredSize(SDL_Renderer *ctx) const override;
     void draw(SDL_Renderer* renderer) override;
     void drawBody(SDL_Renderer* renderer);
+    /// Immediate body used when the skin texture cannot be created
+    void drawBodyTemp(SDL_Renderer* renderer);
 protected:
     bool checkFormat(const std::string& input,const std::string& format);
     bool copySelection();
@@ -123,15 +125,6 @@ protected:
     Texture _captionTex;
     Texture _unitsTex;
     Texture _tempTex;
-
-    struct AsyncTexture;
-    typedef std::shared_ptr<AsyncTexture> AsyncTexturePtr;
-    std::vector<AsyncTexturePtr> _txs;
-
-    AsyncTexturePtr current_texture_ = nullptr;
-
-private:
-    void drawTexture(AsyncTexturePtr& texture, SDL_Renderer* renderer);
 };
 
 /**
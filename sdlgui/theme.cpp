@@ -12,6 +12,8 @@
 #include "resources.h"
 #include <map>
 #include <string>
+#include <cstring>
+#include <algorithm>
 
 #if defined(_WIN32)
 #include <SDL_ttf.h>
@@ -19,6 +21,10 @@
 #include <SDL2/SDL_ttf.h>
 #endif
 
+#include "nanovg.h"
+#include "nanovg_rt.h"
+#include "nanovg_sdl.h"
+
 NAMESPACE_BEGIN(sdlgui)
 
 namespace internal
@@ -81,6 +87,85 @@ Theme::Theme(SDL_Renderer *ctx) {
     TTF_Init();
 }
 
+Theme::~Theme()
+{
+  invalidateSkins();
+  for (auto& it : mGlyphAtlases)
+  {
+    if (it.second.tex.tex)
+      SDL_DestroyTexture(it.second.tex.tex);
+  }
+  if (mGeometryCtx)
+    nvgDeleteSDL(mGeometryCtx);
+}
+
+const NinePatch* Theme::getSkin(SDL_Renderer* renderer, SkinClass cls, uint64_t state,
+                                const Vector2i& size, const PntRect& insets, const SkinPainter& painter)
+{
+  uint64_t key = ((uint64_t)cls << 56) | (state & 0x00ffffffffffffffull);
+
+  auto it = mSkins.find(key);
+  if (it != mSkins.end())
+    return &it->second;
+
+  NinePatch& patch = mSkins[key];
+  patch.insets = insets;
+  patch.tex.rrect = { 0, 0, size.x, size.y };
+
+  /* Painted into a private context like the checkbox jobs, without loadMutex:
+     background jobs hold it for their whole run and would stall the frame */
+  NVGcontext *ctx = nvgCreateRT(NVG_DEBUG, size.x, size.y, 0);
+  if (!ctx)
+    return &patch;
+
+  nvgBeginFrame(ctx, size.x, size.y, 1.0f);
+  painter(ctx, size.x, size.y);
+  nvgEndFrame(ctx);
+
+  patch.tex.tex = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ABGR8888, SDL_TEXTUREACCESS_STATIC, size.x, size.y);
+  if (patch.tex.tex)
+  {
+    SDL_UpdateTexture(patch.tex.tex, nullptr, nvgReadPixelsRT(ctx), size.x * sizeof(uint32_t));
+    SDL_SetTextureBlendMode(patch.tex.tex, SDL_BLENDMODE_BLEND);
+  }
+
+  nvgDeleteRT(ctx);
+  return &patch;
+}
+
+void Theme::invalidateSkins()
+{
+  for (auto& it : mSkins)
+  {
+    if (it.second.tex.tex)
+      SDL_DestroyTexture(it.second.tex.tex);
+  }
+  mSkins.clear();
+}
+
+bool Theme::paintGeometry(SDL_Renderer* renderer, const Vector2i& pos, const Vector2i& size, const SkinPainter& painter)
+{
+  if (mGeometryRenderer != renderer)
+  {
+    if (mGeometryCtx)
+      nvgDeleteSDL(mGeometryCtx);
+    mGeometryCtx = nvgCreateSDL(renderer, NVG_SDL_ANTIALIAS);
+    mGeometryRenderer = renderer;
+  }
+
+  if (!mGeometryCtx)
+    return false;
+
+  int rw, rh;
+  SDL_GetRendererOutputSize(renderer, &rw, &rh);
+
+  nvgBeginFrame(mGeometryCtx, rw, rh, 1.0f);
+  nvgTranslate(mGeometryCtx, pos.x, pos.y);
+  painter(mGeometryCtx, size.x, size.y);
+  nvgEndFrame(mGeometryCtx);
+  return true;
+}
+
 TTF_Font* getFont(const char* fontname, size_t ptsize)
 {
   std::string fullFontName = fontname;
@@ -112,6 +197,58 @@ TTF_Font* getFont(const char* fontname, size_t ptsize)
   return font;
 }
 
+const GlyphAtlas* Theme::getGlyphAtlas(SDL_Renderer* renderer, const char* fontname, size_t ptsize)
+{
+  std::string key = std::string(fontname) + "_" + std::to_string(ptsize);
+  auto it = mGlyphAtlases.find(key);
+  if (it != mGlyphAtlases.end())
+    return &it->second;
+
+  TTF_Font* font = getFont(fontname, ptsize);
+  if (!font)
+    return nullptr;
+
+  /* Render every glyph once, then pack them left to right into a single row */
+  SDL_Surface* surfaces[GlyphAtlas::Count] = {};
+  int width = 0, height = TTF_FontHeight(font);
+  for (int i = 0; i < GlyphAtlas::Count; i++)
+  {
+    SDL_Surface* glyph = TTF_RenderGlyph_Blended(font, Uint16(GlyphAtlas::First + i), SDL_Color{ 255, 255, 255, 255 });
+    if (glyph)
+    {
+      surfaces[i] = SDL_ConvertSurfaceFormat(glyph, SDL_PIXELFORMAT_ARGB8888, 0);
+      SDL_FreeSurface(glyph);
+    }
+    if (surfaces[i])
+    {
+      width += surfaces[i]->w + 1;
+      height = std::max(height, surfaces[i]->h);
+    }
+  }
+
+  GlyphAtlas& atlas = mGlyphAtlases[key];
+  atlas.lineHeight = TTF_FontHeight(font);
+  std::vector<uint32_t> pixels(size_t(std::max(width, 1)) * height, 0);
+  int x = 0;
+  for (int i = 0; i < GlyphAtlas::Count; i++)
+  {
+    SDL_Surface* s = surfaces[i];
+    atlas.glyphs[i] = SDL_Rect{ x, 0, s ? s->w : 0, s ? s->h : 0 };
+    if (!s)
+      continue;
+    for (int y = 0; y < s->h; y++)
+      memcpy(&pixels[size_t(y) * width + x], (uint8_t*)s->pixels + y * s->pitch, s->w * sizeof(uint32_t));
+    x += s->w + 1;
+    SDL_FreeSurface(s);
+  }
+
+  atlas.tex.tex = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, std::max(width, 1), height);
+  atlas.tex.rrect = SDL_Rect{ 0, 0, std::max(width, 1), height };
+  SDL_SetTextureBlendMode(atlas.tex.tex, SDL_BLENDMODE_BLEND);
+  SDL_UpdateTexture(atlas.tex.tex, nullptr, pixels.data(), std::max(width, 1) * sizeof(uint32_t));
+  return &atlas;
+}
+
 int Theme::getTextBounds(const char* fontname, size_t ptsize, const char* text, int *w, int *h)
 {
   TTF_Font* font = getFont(fontname, ptsize);
@@ -259,4 +396,35 @@ void SDL_RenderCopy(SDL_Renderer* renderer, Texture& tx, const Vector2i& pos)
   SDL_RenderCopy(renderer, tx.tex, nullptr, &rect);
 }
 
+void SDL_RenderCopy(SDL_Renderer* renderer, const NinePatch& patch, const SDL_Rect& rect)
+{
+  if (!patch.tex.tex || rect.w <= 0 || rect.h <= 0)
+    return;
+
+  const PntRect& in = patch.insets;
+  int sw = patch.tex.w(), sh = patch.tex.h();
+
+  /* Shrink the fixed borders proportionally when the target is smaller than them */
+  float kx = std::min(1.f, rect.w / (float)std::max(1, in.x1 + in.x2));
+  float ky = std::min(1.f, rect.h / (float)std::max(1, in.y1 + in.y2));
+  int l = (int)(in.x1 * kx), r = (int)(in.x2 * kx);
+  int t = (int)(in.y1 * ky), b = (int)(in.y2 * ky);
+
+  const int sx[4] = { 0, in.x1, sw - in.x2, sw };
+  const int sy[4] = { 0, in.y1, sh - in.y2, sh };
+  const int dx[4] = { rect.x, rect.x + l, rect.x + rect.w - r, rect.x + rect.w };
+  const int dy[4] = { rect.y, rect.y + t, rect.y + rect.h - b, rect.y + rect.h };
+
+  for (int j = 0; j < 3; j++)
+  {
+    for (int i = 0; i < 3; i++)
+    {
+      SDL_Rect src{ sx[i], sy[j], sx[i + 1] - sx[i], sy[j + 1] - sy[j] };
+      SDL_Rect dst{ dx[i], dy[j], dx[i + 1] - dx[i], dy[j + 1] - dy[j] };
+      if (src.w > 0 && src.h > 0 && dst.w > 0 && dst.h > 0)
+        SDL_RenderCopy(renderer, patch.tex.tex, &src, &dst);
+    }
+  }
+}
+
 NAMESPACE_END(sdlgui)
@@ -32,7 +32,43 @@ struct Texture
   inline int h() const { return rrect.h; }
 };
 
+/**
+ * \brief Stretchable widget skin.
+ *
+ * The texture is split by \c insets (left, top, right, bottom) into nine
+ * parts: corners are copied unscaled, edges are stretched along one axis
+ * and the centre is stretched along both, so one small raster serves a
+ * widget of any size.
+ */
+struct NinePatch
+{
+  Texture tex;
+  PntRect insets{ 0, 0, 0, 0 };
+};
+
+/**
+ * \brief Printable ASCII glyphs of one font and size in a single white texture.
+ *
+ * Text drawn from the atlas is tinted per vertex, so any number of strings
+ * in different colors can go out in one SDL_RenderGeometry batch.
+ */
+struct GlyphAtlas
+{
+  static const int First = 32, Count = 95;
+
+  Texture tex;
+  SDL_Rect glyphs[Count];
+  int lineHeight = 0;
+
+  const SDL_Rect* glyph(char c) const
+  {
+    int i = (unsigned char)c - First;
+    return i >= 0 && i < Count ? &glyphs[i] : nullptr;
+  }
+};
+
 void SDL_RenderCopy(SDL_Renderer* renderer, Texture& tex, const Vector2i& pos);
+void SDL_RenderCopy(SDL_Renderer* renderer, const NinePatch& patch, const SDL_Rect& rect);
 /**
  * \class Theme theme.h sdlgui/theme.h
  *
@@ -60,6 +96,7 @@ public:
     int mTabButtonHorizontalPadding;
     int mTabButtonVerticalPadding;
 
+    /// Serializes background raster jobs; the UI thread never waits on it
     std::mutex loadMutex;
 
     /* Generic colors */
@@ -99,6 +136,38 @@ public:
     Color mWindowPopup;
     Color mWindowPopupTransparent;
 
+    /// Widget classes which draw their body from a nine-patch skin
+    enum class SkinClass : uint8_t { Button = 0, TextBox, Window };
+
+    /// Paints a skin into a NanoVG context of the given size
+    typedef std::function<void(NVGcontext* ctx, int w, int h)> SkinPainter;
+
+    /**
+     * \brief Return the nine-patch skin for a widget class and state.
+     *
+     * The skin is rasterized with \c painter at \c size on first use and
+     * cached for the lifetime of the theme (or until \ref invalidateSkins),
+     * so resizing a widget never triggers another raster job. \c state may
+     * use the low 56 bits.
+     */
+    const NinePatch* getSkin(SDL_Renderer* renderer, SkinClass cls, uint64_t state,
+                             const Vector2i& size, const PntRect& insets, const SkinPainter& painter);
+
+    /// Drop all cached skins, e.g. after changing theme colors
+    void invalidateSkins();
+
+    /**
+     * \brief Paint directly into the renderer through SDL_RenderGeometry.
+     *
+     * Runs \c painter on a NanoVG context backed by \ref nvgCreateSDL with the
+     * origin moved to \c pos. Returns false when the geometry back-end is not
+     * available, in which case the caller should fall back to a texture.
+     */
+    bool paintGeometry(SDL_Renderer* renderer, const Vector2i& pos, const Vector2i& size, const SkinPainter& painter);
+
+    /// Glyph atlas for a font and size, built on first use and kept for the lifetime of the theme
+    const GlyphAtlas* getGlyphAtlas(SDL_Renderer* renderer, const char* fontname, size_t ptsize);
+
     void getTexAndRect(SDL_Renderer *renderer, int x, int y, const char *text,
       const char* fontname, size_t ptsize, SDL_Texture **texture, SDL_Rect *rect, SDL_Color *textColor);
 
@@ -117,7 +186,13 @@ public:
                            const char* fontname, size_t ptsize, const Color& textColor);
 
 protected:
-    virtual ~Theme() { };
+    virtual ~Theme();
+
+    std::unordered_map<uint64_t, NinePatch> mSkins;
+    std::unordered_map<std::string, GlyphAtlas> mGlyphAtlases;
+
+    SDL_Renderer* mGeometryRenderer = nullptr;
+    NVGcontext* mGeometryCtx = nullptr;
 };
 
 NAMESPACE_END(sdlgui)
@@ -29,6 +29,19 @@ void VScrollPanel::performLayout(SDL_Renderer *ctx)
     mChildPreferredHeight = child->preferredSize(ctx).y;
     child->setPosition({ 0, 0 });
     child->setSize({ mSize.x - 12, mChildPreferredHeight });
+    updateOffset();
+}
+
+void VScrollPanel::updateOffset()
+{
+    /* The content is shifted through childOffset(), so only a scroll change
+       invalidates the geometry caches */
+    int offset = -mScroll*(mChildPreferredHeight - mSize.y);
+    if (offset != mDOffset)
+    {
+      mDOffset = offset;
+      invalidateGeometry();
+    }
 }
 
 Vector2i VScrollPanel::preferredSize(SDL_Renderer *ctx) const
@@ -48,6 +61,7 @@ bool VScrollPanel::mouseDragEvent(const Vector2i &, const Vector2i &rel,  int, i
 
     mScroll = std::max((float) 0.0f, std::min((float) 1.0f,
                  mScroll + rel.y / (float)(mSize.y - 8 - scrollh)));
+    updateOffset();
     return true;
 }
 
@@ -59,6 +73,7 @@ bool VScrollPanel::scrollEvent(const Vector2i &/* p */, const Vector2f &rel)
 
     mScroll = std::max((float) 0.0f, std::min((float) 1.0f,
             mScroll - scrollAmount / (float)(mSize.y - 8 - scrollh)));
+    updateOffset();
     return true;
 }
 
@@ -78,6 +93,17 @@ bool VScrollPanel::mouseMotionEvent(const Vector2i &p, const Vector2i &rel, int
     return mChildren[0]->mouseMotionEvent(p - _pos + Vector2i{ 0, shift }, rel, button, modifiers);
 }
 
+Widget *VScrollPanel::findWidget(const Vector2i &p)
+{
+    if (!contains(p))
+        return nullptr;
+    if (mChildren.empty() || !mChildren[0]->visible())
+        return this;
+    int shift = (int) (mScroll*(mChildPreferredHeight - mSize.y));
+    Widget *hit = mChildren[0]->findWidget(p - _pos + Vector2i{ 0, shift });
+    return hit ? hit : this;
+}
+
 void VScrollPanel::draw(SDL_Renderer *renderer) 
 {
     if (mChildren.empty())
@@ -93,16 +119,10 @@ void VScrollPanel::draw(SDL_Renderer *renderer)
     //SDL_SetRenderDrawColor(renderer, 255, 0, 0, 255);
     //SDL_RenderDrawRect(renderer, &brect);
 
+    updateOffset();
+
     if (child->visible())
-    {
-      const Vector2i savepos = child->position();
-      Vector2i npos = savepos;
-      mDOffset = -mScroll*(mChildPreferredHeight - mSize.y);
-      npos.y += mDOffset;
-      child->setPosition(npos);
       child->draw(renderer);
-      child->setPosition(savepos);
-    }
 
     SDL_Color sc = mTheme->mBorderDark.toSdlColor();
     SDL_Rect srect{ ap.x + mSize.x - 12, ap.y + 4, 8, mSize.y - 8 };
@@ -33,13 +33,20 @@ public:
     bool scrollEvent(const Vector2i &p, const Vector2f &rel) override;
     bool mouseButtonEvent(const Vector2i &p, int button, bool down, int modifiers) override;
     bool mouseMotionEvent(const Vector2i &p, const Vector2i &rel, int button, int modifiers) override;
+    Widget *findWidget(const Vector2i &p) override;
     void draw(SDL_Renderer *render) override;
 
+    /// The content moves with the scroll position, so it is hit tested recursively
+    bool indexableChildren() const override { return false; }
+    Vector2i childOffset() const override { return Vector2i(0, mDOffset); }
     SDL_Point getAbsolutePos() const override;
     PntRect getAbsoluteCliprect() const override;
     int getAbsoluteTop() const override;
 
 protected:
+    /// Recompute the content offset from the scroll position
+    void updateOffset();
+
     int mChildPreferredHeight;
     float mScroll;
     int mDOffset = 0;
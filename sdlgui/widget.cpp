@@ -21,11 +21,114 @@
 
 NAMESPACE_BEGIN(sdlgui)
 
+namespace
+{
+  thread_local WidgetArena *sCurrentArena = nullptr;
+
+  /* Precedes every widget allocation; keeps the payload 16 byte aligned */
+  struct alignas(16) BlockHeader
+  {
+    WidgetArena *arena;
+    size_t sizeClass;
+  };
+}
+
+WidgetArena::~WidgetArena()
+{
+  for (auto slab : mSlabs)
+    ::operator delete(slab);
+}
+
+void WidgetArena::release()
+{
+  mReleased = true;
+  if (mLive == 0)
+    delete this;
+}
+
+WidgetArena::Scope::Scope(WidgetArena *arena)
+  : mArena(arena), mPrevious(sCurrentArena)
+{
+  sCurrentArena = arena;
+}
+
+WidgetArena::Scope::~Scope()
+{
+  assert(sCurrentArena == mArena && "WidgetArena scopes must close in reverse order");
+  sCurrentArena = mPrevious;
+}
+
+WidgetArena *WidgetArena::current()
+{
+  return sCurrentArena;
+}
+
+void *WidgetArena::allocate(size_t size)
+{
+  size_t total = size + sizeof(BlockHeader);
+  size_t sizeClass = (total + Granularity - 1) / Granularity;
+
+  BlockHeader *header;
+  WidgetArena *arena = sCurrentArena;
+  if (arena && sizeClass < ClassCount)
+  {
+    header = (BlockHeader *) arena->take(sizeClass);
+  }
+  else
+  {
+    header = (BlockHeader *) ::operator new(total);
+    arena = nullptr;
+  }
+  header->arena = arena;
+  header->sizeClass = sizeClass;
+  return header + 1;
+}
+
+void WidgetArena::deallocate(void *ptr)
+{
+  if (!ptr)
+    return;
+  BlockHeader *header = (BlockHeader *) ptr - 1;
+  if (header->arena)
+    header->arena->give(header, header->sizeClass);
+  else
+    ::operator delete(header);
+}
+
+void *WidgetArena::take(size_t sizeClass)
+{
+  ++mLive;
+  if (void *block = mFreeLists[sizeClass])
+  {
+    mFreeLists[sizeClass] = *(void **) block;
+    return block;
+  }
+
+  size_t bytes = sizeClass * Granularity;
+  if (mCursor == nullptr || (size_t) (mEnd - mCursor) < bytes)
+  {
+    mCursor = (char *) ::operator new(SlabSize);
+    mEnd = mCursor + SlabSize;
+    mSlabs.push_back(mCursor);
+  }
+  void *block = mCursor;
+  mCursor += bytes;
+  return block;
+}
+
+void WidgetArena::give(void *block, size_t sizeClass)
+{
+  *(void **) block = mFreeLists[sizeClass];
+  mFreeLists[sizeClass] = block;
+  if (--mLive == 0 && mReleased)
+    delete this;
+}
+
 Widget::Widget(Widget *parent)
     : mParent(nullptr), mTheme(nullptr), mLayout(nullptr),
       _pos(Vector2i::Zero()), mSize(Vector2i::Zero()),
       mFixedSize(Vector2i::Zero()), mVisible(true), mEnabled(true),
-      mFocused(false), mMouseFocus(false), mTooltip(""), mFontSize(-1.0f),
+      mFocused(false), mMouseFocus(false), mGeometryBody(false), mTooltip(""), mFontSize(-1.0f),
       mCursor(Cursor::Arrow) 
 {
     if (parent)
@@ -85,24 +188,85 @@ void Widget::performLayout(SDL_Renderer *ctx)
     }
 }
 
+void Widget::setId(const std::string &id)
+{
+  if (id == mId)
+    return;
+
+  Screen *sc = screen();
+  if (sc)
+    sc->indexIds(this, false, false);
+  mId = id;
+  if (sc)
+    sc->indexIds(this, true, false);
+}
+
 Widget* Widget::find(const std::string& id, bool inchildren)
 {
   if (mId == id)
     return this;
 
-  if (inchildren)
+  if (!inchildren)
+    return nullptr;
+
+  if (Screen *sc = screen())
   {
-    for (auto* child : mChildren)
+    auto it = sc->mIdIndex.find(id);
+    if (it == sc->mIdIndex.end())
+      return nullptr;
+    if (it->second.size() == 1)
     {
-      Widget* w = child->find(id, inchildren);
-      if (w)
-        return w;
+      /* Unique id: only check that it lives below this widget */
+      Widget *w = it->second[0].widget;
+      for (Widget *p = w; p; p = p->parent())
+        if (p == this)
+          return w;
+      return nullptr;
     }
   }
 
+  for (auto* child : mChildren)
+  {
+    Widget* w = child->find(id, inchildren);
+    if (w)
+      return w;
+  }
+
   return nullptr;
 }
 
+Widget *Widget::gfind(const std::string& id)
+{
+  Widget* parent = this;
+  while (parent->parent()) parent = parent->parent();
+
+  return parent->find(id, true);
+}
+
+void *Widget::gfindTyped(const std::string& id, const std::type_info& type, void *(*cast)(Widget *))
+{
+  Screen *sc = screen();
+  if (sc)
+  {
+    auto it = sc->mIdIndex.find(id);
+    if (it == sc->mIdIndex.end())
+      return nullptr;
+    if (it->second.size() == 1)
+    {
+      auto &entry = it->second[0];
+      if (entry.castType != &type)
+      {
+        entry.castType = &type;
+        entry.cast = cast(entry.widget);
+      }
+      return entry.cast;
+    }
+  }
+
+  Widget *w = gfind(id);
+  return w ? cast(w) : nullptr;
+}
+
 Widget *Widget::findWidget(const Vector2i &p)
 {
     for (auto it = mChildren.rbegin(); it != mChildren.rend(); ++it) 
@@ -131,19 +295,11 @@ bool Widget::mouseButtonEvent(const Vector2i &p, int button, bool down, int modi
 
 bool Widget::mouseMotionEvent(const Vector2i &p, const Vector2i &rel, int button, int modifiers)
 {
-    for (auto it = mChildren.rbegin(); it != mChildren.rend(); ++it) 
-    {
-        Widget *child = *it;
-        if (!child->visible())
-            continue;
-        bool contained = child->contains(p - _pos);
-        bool prevContained = child->contains(p - _pos - rel);
-        if (contained != prevContained)
-            child->mouseEnterEvent(p, contained);
-        if ((contained || prevContained) &&
-            child->mouseMotionEvent(p - _pos, rel, button, modifiers))
-            return true;
-    }
+    /* Enter/leave transitions were already sent by the screen, which also
+       picked the child under the cursor: only follow the hover path */
+    Widget *child = mHoverChild;
+    if (child && child->visible())
+        return child->mouseMotionEvent(p - _pos, rel, button, modifiers);
     return false;
 }
 
@@ -194,6 +350,11 @@ void Widget::addChild(int index, Widget * widget)
     widget->incRef();
     widget->setParent(this);
     widget->setTheme(mTheme);
+
+    /* Fresh widgets have neither an id nor children yet, skip the screen lookup */
+    if (!widget->mId.empty() || !widget->mChildren.empty())
+        if (Screen *sc = screen())
+            sc->indexIds(widget, true, true);
 }
 
 void Widget::addChild(Widget * widget) 
@@ -204,6 +365,11 @@ void Widget::addChild(Widget * widget)
 void Widget::removeChild(const Widget *widget) 
 {
     mChildren.erase(std::remove(mChildren.begin(), mChildren.end(), widget), mChildren.end());
+    if (mHoverChild == widget)
+        mHoverChild = nullptr;
+    if (Screen *sc = screen())
+        sc->indexIds(const_cast<Widget *>(widget), false, true);
+    widget->geometryChanged();
     widget->decRef();
 }
 
@@ -211,6 +377,11 @@ void Widget::removeChild(int index)
 {
     Widget *widget = mChildren[index];
     mChildren.erase(mChildren.begin() + index);
+    if (mHoverChild == widget)
+        mHoverChild = nullptr;
+    if (Screen *sc = screen())
+        sc->indexIds(widget, false, true);
+    widget->geometryChanged();
     widget->decRef();
 }
 
@@ -224,44 +395,61 @@ int Widget::childIndex(Widget *widget) const
 
 Window *Widget::window() 
 {
-    Widget *widget = this;
-    while (true) 
+    if (mWindowEpoch != sHierarchyEpoch)
     {
-        if (!widget)
-            throw std::runtime_error(
-                "Widget:internal error (could not find parent window)");
-        Window *window = dynamic_cast<Window *>(widget);
-        if (window)
-            return window;
-        widget = widget->parent();
+        Widget *widget = this;
+        while (widget && !widget->isKind(KindWindow))
+            widget = widget->parent();
+        mWindow = static_cast<Window *>(widget);
+        mWindowEpoch = sHierarchyEpoch;
     }
+    if (!mWindow)
+        throw std::runtime_error(
+            "Widget:internal error (could not find parent window)");
+    return mWindow;
 }
 
-int Widget::getAbsoluteLeft() const
+Screen *Widget::screen()
+{
+    Widget *widget = this;
+    while (widget->parent())
+        widget = widget->parent();
+    return widget->isKind(KindScreen) ? static_cast<Screen *>(widget) : nullptr;
+}
+
+WidgetArena *Widget::allocationArena()
 {
-  return mParent
-    ? mParent->getAbsoluteLeft() + _pos.x
-    : _pos.x;
+    Screen *sc = screen();
+    WidgetArena *arena = sc ? sc->widgetArena() : nullptr;
+    return arena ? arena : WidgetArena::current();
 }
 
-SDL_Point Widget::getAbsolutePos() const
+uint32_t Widget::sGeometryEpoch = 1;
+uint32_t Widget::sHierarchyEpoch = 1;
+bool Widget::sSpatialIndexing = false;
+
+void Widget::geometryChanged() const
 {
-  if (mParent)
+  invalidateGeometry();
+  if (!sSpatialIndexing)
+    return;
+
+  for (Widget* w = mParent; w; w = w->mParent)
   {
-    SDL_Point p = mParent->getAbsolutePos();
-    return SDL_Point{ p.x + _pos.x, p.y + _pos.y };
+    if (!w->indexableChildren())
+      return;
+    w->descendantGeometryChanged();
   }
-  else
-    return SDL_Point{ _pos.x, _pos.y };
 }
 
-PntRect Widget::getAbsoluteCliprect() const
+void Widget::updateAbsoluteGeometry() const
 {
   if (mParent)
   {
+    mAbsPos = mParent->absolutePosition() + mParent->childOffset() + _pos;
+
     PntRect pclip = mParent->getAbsoluteCliprect();
-    SDL_Point pp = getAbsolutePos();
-    PntRect mclip{ pp.x, pp.y, pp.x + width(), pp.y + height() };
+    PntRect mclip{ mAbsPos.x, mAbsPos.y, mAbsPos.x + width(), mAbsPos.y + height() };
     if (pclip.x1 < mclip.x1)
       pclip.x1 = mclip.x1;
     if (pclip.y1 < mclip.y1)
@@ -271,19 +459,38 @@ PntRect Widget::getAbsoluteCliprect() const
     if (mclip.y2 < pclip.y2)
       pclip.y2 = mclip.y2;
 
-    return pclip;
+    mAbsClip = pclip;
   }
   else
   {
-    return PntRect{ _pos.x, _pos.y, _pos.x + width(), _pos.y + height()};
+    mAbsPos = _pos;
+    mAbsClip = PntRect{ _pos.x, _pos.y, _pos.x + width(), _pos.y + height() };
   }
+
+  mGeometryEpoch = sGeometryEpoch;
+}
+
+int Widget::getAbsoluteLeft() const
+{
+  return absolutePosition().x;
+}
+
+SDL_Point Widget::getAbsolutePos() const
+{
+  Vector2i p = absolutePosition();
+  return SDL_Point{ p.x, p.y };
+}
+
+PntRect Widget::getAbsoluteCliprect() const
+{
+  if (mGeometryEpoch != sGeometryEpoch)
+    updateAbsoluteGeometry();
+  return mAbsClip;
 }
 
 int Widget::getAbsoluteTop() const
 {
-  return mParent
-    ? mParent->getAbsoluteTop() + _pos.y
-    : _pos.y;
+  return absolutePosition().y;
 }
 
 void Widget::requestFocus() 
@@ -297,7 +504,7 @@ void Widget::requestFocus()
 void Widget::draw(SDL_Renderer* renderer)
 {
   for (auto child : mChildren)
-    if (child->visible())
+    if (child->visible() && !child->culled())
       child->draw(renderer);
 }
 
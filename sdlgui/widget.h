@@ -14,10 +14,12 @@
 #include <sdlgui/theme.h>
 #include <sdlgui/layout.h>
 #include <vector>
+#include <typeinfo>
 
 NAMESPACE_BEGIN(sdlgui)
 
 class Window;
+class Screen;
 class Label;
 class ToolButton;
 class MessageDialog;
@@ -31,6 +33,75 @@ class Slider;
 class ImagePanel;
 class DropdownBox;
 class TextBox;
+
+/**
+ * \class WidgetArena widget.h sdl_gui/widget.h
+ *
+ * \brief Slab allocator for widget objects.
+ *
+ * While an arena is current (see \ref Scope, which \ref Widget::wdg opens for
+ * the arena of the parent's screen), widgets created on this thread
+ * are carved from 64 KiB slabs with per-size free lists instead of separate
+ * heap allocations. A destroyed widget returns its block to the arena it came
+ * from. The slabs are freed in one go once the owner has called \ref release
+ * and the last widget allocated from them is gone, so tearing down a window
+ * subtree costs only the destructors. Not thread safe: widgets must be created
+ * and destroyed on the UI thread.
+ */
+class WidgetArena
+{
+public:
+    /// Size classes are multiples of this many bytes
+    static const size_t Granularity = 32;
+    /// Blocks larger than (ClassCount - 1) * Granularity go to the heap
+    static const size_t ClassCount = 64;
+    static const size_t SlabSize = 64 * 1024;
+
+    /// Create an empty arena owned by the caller
+    static WidgetArena *create() { return new WidgetArena(); }
+
+    /// Drop the owner's reference; the slabs are freed once no widget uses them
+    void release();
+
+    /// Make an arena current on this thread for the lifetime of the scope; scopes must nest
+    class Scope
+    {
+    public:
+        explicit Scope(WidgetArena *arena);
+        ~Scope();
+    private:
+        WidgetArena *mArena, *mPrevious;
+    };
+
+    /// Return the arena current on this thread, if any
+    static WidgetArena *current();
+
+    /// Allocate from the current arena, or from the heap when there is none
+    static void *allocate(size_t size);
+    /// Return a block to the arena (or heap) it was allocated from
+    static void deallocate(void *ptr);
+
+    /// Number of widgets currently allocated from this arena
+    size_t liveBlocks() const { return mLive; }
+    /// Number of slabs reserved by this arena
+    size_t slabCount() const { return mSlabs.size(); }
+
+private:
+    WidgetArena() {}
+    ~WidgetArena();
+    WidgetArena(const WidgetArena &) = delete;
+    WidgetArena &operator=(const WidgetArena &) = delete;
+
+    void *take(size_t sizeClass);
+    void give(void *block, size_t sizeClass);
+
+    std::vector<char *> mSlabs;
+    char *mCursor = nullptr, *mEnd = nullptr;
+    void *mFreeLists[ClassCount] = {};
+    size_t mLive = 0;
+    bool mReleased = false;
+};
+
 /**
  * \class Widget widget.h sdl_gui/widget.h
  *
@@ -47,12 +118,16 @@ public:
     /// Construct a new widget with the given parent widget
     Widget(Widget *parent);
 
+    /// Widgets are allocated from the current \ref WidgetArena, if any
+    static void *operator new(size_t size) { return WidgetArena::allocate(size); }
+    static void operator delete(void *ptr) { WidgetArena::deallocate(ptr); }
+
     /// Return the parent widget
     Widget *parent() { return mParent; }
     /// Return the parent widget
     const Widget *parent() const { return mParent; }
     /// Set the parent widget
-    void setParent(Widget *parent) { mParent = parent; }
+    void setParent(Widget *parent) { mParent = parent; mCulled = false; ++sHierarchyEpoch; geometryChanged(); }
 
     /// Return the used \ref Layout generator
     Layout *layout() { return mLayout; }
@@ -71,31 +146,43 @@ public:
     /// Return the position relative to the parent widget
     const Vector2i &position() const { return _pos; }
     /// Set the position relative to the parent widget
-    void setPosition(const Vector2i &pos) { _pos = pos; }
-    void setPosition(int x, int y) { _pos = { x, y }; }
+    void setPosition(const Vector2i &pos) { _pos = pos; geometryChanged(); }
+    void setPosition(int x, int y) { _pos = { x, y }; geometryChanged(); }
 
     /// Return the absolute position on screen
     Vector2i absolutePosition() const
     {
-        return mParent 
-                  ? (mParent->absolutePosition() + _pos) 
-                  : _pos;
+        if (mGeometryEpoch != sGeometryEpoch)
+            updateAbsoluteGeometry();
+        return mAbsPos;
     }
 
+    /**
+     * \brief Mark the cached absolute positions and clip rects of all widgets as stale.
+     *
+     * Called by every setter that moves, resizes or re-parents a widget; code that
+     * writes \c _pos or \c mSize directly must call it as well. The caches are then
+     * refreshed lazily, parents first, so each widget recomputes them once.
+     */
+    static void invalidateGeometry() { ++sGeometryEpoch; }
+
+    /// Current geometry epoch, changes whenever any widget moves or resizes
+    static uint32_t geometryEpoch() { return sGeometryEpoch; }
+
     /// Return the size of the widget
     const Vector2i &size() const { return mSize; }
     /// set the size of the widget
-    void setSize(const Vector2i &size) { mSize = size; }
+    void setSize(const Vector2i &size) { mSize = size; geometryChanged(); }
 
     /// Return the width of the widget
     int width() const { return mSize.x; }
     /// Set the width of the widget
-    void setWidth(int width) { mSize.x = width; }
+    void setWidth(int width) { mSize.x = width; geometryChanged(); }
 
     /// Return the height of the widget
     int height() const { return mSize.y; }
     /// Set the height of the widget
-    void setHeight(int height) { mSize.y = height; }
+    void setHeight(int height) { mSize.y = height; geometryChanged(); }
 
     /**
      * \brief Set the fixed size of this widget
@@ -125,7 +212,7 @@ public:
     /// Return whether or not the widget is currently visible (assuming all parents are visible)
     bool visible() const { return mVisible; }
     /// Set whether or not the widget is currently visible (assuming all parents are visible)
-    void setVisible(bool visible) { mVisible = visible; }
+    void setVisible(bool visible) { if (mVisible != visible) { mVisible = visible; invalidateGeometry(); } }
 
     /// Check if this widget is currently visible, taking parent widgets into account
     bool visibleRecursive() const {
@@ -181,15 +268,38 @@ public:
     template<typename WidgetClass, typename... Args>
     WidgetClass& wdg(const Args&... args)
     {
+      /* Children of a screen with an arena, and whatever their constructors create, come from it */
+      WidgetArena::Scope scope(allocationArena());
       WidgetClass* widget = new WidgetClass( this, args... );
       return *widget;
     }
 
-    /// Walk up the hierarchy and return the parent window
+    /// Return the parent window (cached until the hierarchy changes)
     Window *window();
 
+    /// Walk up the hierarchy and return the screen this widget is attached to, if any
+    Screen *screen();
+
+    /// Arena for new children: the one enabled on the screen, else the current one
+    WidgetArena *allocationArena();
+
+    /// Capability bits set by the constructors, tested instead of dynamic_cast on hot paths
+    enum Kind : uint32_t
+    {
+        KindWindow = 1 << 0,
+        KindPopup  = 1 << 1,
+        KindScreen = 1 << 2,
+        KindButton = 1 << 3,
+        KindLabel  = 1 << 4
+    };
+
+    /// Return the capability bits of this widget
+    uint32_t kind() const { return mKind; }
+    /// Check whether this widget has all of the given capability bits
+    bool isKind(uint32_t kind) const { return (mKind & kind) == kind; }
+
     /// Associate this widget with an ID value (optional)
-    void setId(const std::string &id) { mId = id; }
+    void setId(const std::string &id);
     /// Return the ID value associated with this widget, if any
     const std::string &id() const { return mId; }
 
@@ -205,6 +315,11 @@ public:
     /// Request the focus to be moved to this widget
     void requestFocus();
 
+    /// Return whether the body is drawn as SDL geometry every frame instead of from a rasterized texture
+    bool geometryBody() const { return mGeometryBody; }
+    /// Draw the body through SDL_RenderGeometry (needs SDL 2.0.18, falls back to textures otherwise)
+    void setGeometryBody(bool geometry) { mGeometryBody = geometry; }
+
     const std::string &tooltip() const { return mTooltip; }
     void setTooltip(const std::string &tooltip) { mTooltip = tooltip; }
 
@@ -228,34 +343,41 @@ public:
     }
 
     /// Determine the widget located at the given position value (recursive)
-    Widget *findWidget(const Vector2i &p);
+    virtual Widget *findWidget(const Vector2i &p);
+
+    /// Whether a window spatial index may store this widget's children (see \ref Window::setSpatialIndex).
+    /// Widgets whose children move with internal state (e.g. scrolling) return false and are hit tested recursively.
+    virtual bool indexableChildren() const { return true; }
+    /// Offset added to the positions of all children, e.g. by a scrolling container
+    virtual Vector2i childOffset() const { return Vector2i::Zero(); }
+    /// Whether the last geometry mirror pass found this subtree entirely off screen
+    bool culled() const { return mCulled; }
     Widget *find(const std::string& id, bool inchildren=true);
 
 
-    Widget *gfind(const std::string& id)
-    {
-      Widget* parent = this;
-      while (parent->parent()) parent = parent->parent();
-
-      return parent->find(id, true);
-    }
+    /// Find a widget by id anywhere in the tree; uses the screen's id index when attached
+    Widget *gfind(const std::string& id);
 
+    /// Typed \ref gfind; the cast result is cached in the screen's id index
     template<typename RetClass>
     RetClass *gfind(const std::string& id)
     { 
-      Widget* f = gfind(id);
-      return f ? f->cast<RetClass>() : nullptr;
+      return static_cast<RetClass*>(gfindTyped(id, typeid(RetClass),
+        [](Widget* w) -> void* { return w->cast<RetClass>(); }));
     }
 
     /// Handle a mouse button event (default implementation: propagate to children)
     virtual bool mouseButtonEvent(const Vector2i &p, int button, bool down, int modifiers);
 
-    /// Handle a mouse motion event (default implementation: propagate to children)
+    /// Handle a mouse motion event (default implementation: propagate to the hovered child)
     virtual bool mouseMotionEvent(const Vector2i &p, const Vector2i &rel, int button, int modifiers);
 
     /// Handle a mouse drag event (default implementation: do nothing)
     virtual bool mouseDragEvent(const Vector2i &p, const Vector2i &rel, int button, int modifiers);
 
+    /// Whether drags on this widget need every motion event even when the screen batches input
+    virtual bool wantsRawMotion() const { return false; }
+
     /// Handle a mouse enter/leave event (default implementation: record this fact, but do nothing)
     virtual bool mouseEnterEvent(const Vector2i &p, bool enter);
 
@@ -292,6 +414,7 @@ public:
     Widget& withFontSize(int size) { setFontSize(size); return *this; }
     Widget& withFixedSize(const Vector2i& size) { setFixedSize(size); return *this; }
     Widget& withTooltip(const std::string& text) { setTooltip(text); return *this; }
+    Widget& withGeometryBody(bool geometry = true) { setGeometryBody(geometry); return *this; }
 
     template<typename LayoutClass,typename... Args>
     Widget& withLayout(const Args&... args) { setLayout(new LayoutClass(args...)); return *this; }
@@ -319,7 +442,19 @@ protected:
     /// Free all resources used by the widget and any children
     virtual ~Widget();
 
+    void *gfindTyped(const std::string& id, const std::type_info& type, void *(*cast)(Widget *));
+
+    /// Recompute the cached absolute position and clip rect from the parent's cache
+    void updateAbsoluteGeometry() const;
+
+    /// Invalidate the geometry caches and notify ancestors that keep a spatial index
+    void geometryChanged() const;
+    /// Called on every ancestor when a widget below it moves, resizes or is added/removed
+    virtual void descendantGeometryChanged() {}
+
 protected:
+    friend class Screen;
+
     Widget *mParent;
     ref<Theme> mTheme;
     ref<Layout> mLayout;
@@ -329,9 +464,27 @@ protected:
     std::vector<Widget *> mChildren;
     bool mVisible, mEnabled;
     bool mFocused, mMouseFocus;
+    bool mGeometryBody;
+    bool mCulled = false;
     std::string mTooltip;
     int mFontSize;
     Cursor mCursor;
+    uint32_t mKind = 0;
+
+    /* Parent window cache, valid while mWindowEpoch == sHierarchyEpoch */
+    Window *mWindow = nullptr;
+    uint32_t mWindowEpoch = 0;
+    static uint32_t sHierarchyEpoch;
+
+    /* World-space geometry cache, valid while mGeometryEpoch == sGeometryEpoch */
+    mutable Vector2i mAbsPos;
+    mutable PntRect mAbsClip;
+    mutable uint32_t mGeometryEpoch = 0;
+    static uint32_t sGeometryEpoch;
+    static bool sSpatialIndexing;
+
+    /* Next widget on the screen's hover path, maintained by Screen::updateHover */
+    Widget *mHoverChild = nullptr;
 };
 
 NAMESPACE_END(sdlgui)
@@ -12,146 +12,78 @@
 #include <sdlgui/theme.h>
 #include <sdlgui/screen.h>
 #include <sdlgui/layout.h>
+#include <sdlgui/popup.h>
 #if defined(_WIN32)
 #include <SDL.h>
 #else
 #include <SDL2/SDL.h>
 #endif
-#include <thread>
 
 #include "nanovg.h"
-#define NANOVG_RT_IMPLEMENTATION
-#define NANORT_IMPLEMENTATION
-#include "nanovg_rt.h"
 
 NAMESPACE_BEGIN(sdlgui)
 
-struct Window::AsyncTexture
+/* Uniform grid over the window-local rects of all descendants. Cells list widgets in
+   depth-first order, so the last visible hit in a cell is what a recursive search finds. */
+struct Window::SpatialIndex
 {
-  int id;
-  Texture tex;
-  NVGcontext* ctx = nullptr;
+  enum { CellSize = 32 };
 
-  bool ready() const { return tex.tex != nullptr; }
+  int cols = 0, rows = 0;
+  std::vector<std::vector<Widget*>> cells;
+  bool dirty = true;
 
-  AsyncTexture(int _id) : id(_id) {};
-
-  void load(Window* ptr, int dx, int dy, bool mouseFocus)
+  void build(Window* wnd)
   {
-    Window* wnd = ptr;
-    AsyncTexture* self = this;
-    std::thread tgr([=]() {
-      Theme* mTheme = wnd->theme();
-
-      int ww = wnd->width();
-      int hh = wnd->height();
-      int ds = mTheme->mWindowDropShadowSize;
-
-      Vector2i mPos(dx + ds, dy + ds);
-
-      int realw = ww + 2 * ds + dx; //with + 2*shadow + offset
-      int realh = hh + 2 * ds + dy;
-      NVGcontext *ctx = nvgCreateRT(NVG_DEBUG, realw, realh, 0);
-
-      float pxRatio = 1.0f;
-      nvgBeginFrame(ctx, realw, realh, pxRatio);
-
-      int cr = mTheme->mWindowCornerRadius;
-      int headerH = mTheme->mWindowHeaderHeight;
-
-      /* Draw window */
-      nvgSave(ctx);
-      nvgBeginPath(ctx);
-      nvgRoundedRect(ctx, mPos.x, mPos.y, ww, hh, cr);
-
-      nvgFillColor(ctx, (mouseFocus ? mTheme->mWindowFillFocused
-                                    : mTheme->mWindowFillUnfocused).toNvgColor());
-      nvgFill(ctx);
-
-
-      /* Draw a drop shadow */
-      if (wnd->dropShadowEnabled()) {
-        NVGpaint shadowPaint = nvgBoxGradient(
-          ctx, mPos.x, mPos.y, ww, hh, cr * 2, ds * 2,
-          mTheme->mDropShadow.toNvgColor(), 
-          mTheme->mTransparent.toNvgColor());
-
-        nvgSave(ctx);
-        nvgResetScissor(ctx);
-        nvgBeginPath(ctx);
-        nvgRect(ctx, mPos.x - ds, mPos.y - ds, ww + 2 * ds, hh + 2 * ds);
-        nvgRoundedRect(ctx, mPos.x, mPos.y, ww, hh, cr);
-        nvgPathWinding(ctx, NVG_HOLE);
-        nvgFillPaint(ctx, shadowPaint);
-        nvgFill(ctx);
-        nvgRestore(ctx);
-      }
-
-      /* Draw header */
-      NVGpaint headerPaint = nvgLinearGradient(
-        ctx, mPos.x, mPos.y, mPos.x,
-        mPos.y + headerH,
-        mTheme->mWindowHeaderGradientTop.toNvgColor(),
-        mTheme->mWindowHeaderGradientBot.toNvgColor());
-
-      nvgBeginPath(ctx);
-      nvgRoundedRect(ctx, mPos.x, mPos.y, ww, headerH, cr);
-
-      nvgFillPaint(ctx, headerPaint);
-      nvgFill(ctx);
-
-      nvgBeginPath(ctx);
-      nvgRoundedRect(ctx, mPos.x, mPos.y, ww, headerH, cr);
-      nvgStrokeColor(ctx, mTheme->mWindowHeaderSepTop.toNvgColor());
-
-      nvgSave(ctx);
-      nvgIntersectScissor(ctx, mPos.x, mPos.y, ww, 0.5f);
-      nvgStroke(ctx);
-      nvgRestore(ctx);
-
-      nvgBeginPath(ctx);
-      nvgMoveTo(ctx, mPos.x + 0.5f, mPos.y + headerH - 1.5f);
-      nvgLineTo(ctx, mPos.x + ww - 0.5f, mPos.y + headerH - 1.5);
-      nvgStrokeColor(ctx, mTheme->mWindowHeaderSepBot.toNvgColor());
-      nvgStroke(ctx);
-
-      nvgEndFrame(ctx);
-
-      self->tex.rrect = { 0, 0, realw, realh };
-      self->ctx = ctx;
-    });
-
-    tgr.detach();
+    cols = std::max(1, (wnd->width() + CellSize) / CellSize);
+    rows = std::max(1, (wnd->height() + CellSize) / CellSize);
+    cells.assign(cols * rows, std::vector<Widget*>());
+
+    Vector2i origin = wnd->absolutePosition();
+    insertChildren(wnd, origin);
+    dirty = false;
   }
 
-  void perform(SDL_Renderer* renderer)
+  void insertChildren(Widget* widget, const Vector2i& origin)
   {
-    if (!ctx)
-      return;
-
-    unsigned char *rgba = nvgReadPixelsRT(ctx);
-
-    tex.tex = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ABGR8888, SDL_TEXTUREACCESS_STREAMING, tex.w(), tex.h());
+    for (Widget* child : widget->children())
+    {
+      Vector2i lt = child->absolutePosition() - origin;
+      Vector2i rb = lt + child->size();
 
-    int pitch;
-    uint8_t *pixels;
-    int ok = SDL_LockTexture(tex.tex, nullptr, (void **)&pixels, &pitch);
-    memcpy(pixels, rgba, sizeof(uint32_t) * tex.w() * tex.h());
-    SDL_SetTextureBlendMode(tex.tex, SDL_BLENDMODE_BLEND);
-    SDL_UnlockTexture(tex.tex);
+      int x1 = std::max(0, lt.x / CellSize), x2 = std::min(cols - 1, rb.x / CellSize);
+      int y1 = std::max(0, lt.y / CellSize), y2 = std::min(rows - 1, rb.y / CellSize);
+      for (int y = y1; y <= y2; y++)
+        for (int x = x1; x <= x2; x++)
+          cells[y * cols + x].push_back(child);
 
-    nvgDeleteRT(ctx);
-    ctx = nullptr;
+      if (child->indexableChildren())
+        insertChildren(child, origin);
+    }
   }
 
+  const std::vector<Widget*>* cell(const Vector2i& local) const
+  {
+    int x = local.x / CellSize, y = local.y / CellSize;
+    if (local.x < 0 || local.y < 0 || x >= cols || y >= rows)
+      return nullptr;
+    return &cells[y * cols + x];
+  }
 };
 
 Window::Window(Widget *parent, const std::string &title)
     : Widget(parent), mTitle(title), mButtonPanel(nullptr), mModal(false), mDrag(false) 
 {
+  mKind |= KindWindow;
   _titleTex.dirty = true;
 }
 
+Window::~Window()
+{
+  for (auto popup : mPopups)
+    popup->mParentWindow = nullptr;
+}
+
 Vector2i Window::preferredSize(SDL_Renderer *ctx) const
 {
     if (mButtonPanel)
@@ -196,6 +128,58 @@ void Window::performLayout(SDL_Renderer *ctx)
         mButtonPanel->setPosition({ width() - (mButtonPanel->preferredSize(ctx).x + 5), 3 });
         mButtonPanel->performLayout(ctx);
     }
+
+    if (mSpatialIndex)
+        mSpatialIndex->build(this);
+}
+
+void Window::setSpatialIndex(bool enabled)
+{
+    if (enabled == (mSpatialIndex != nullptr))
+        return;
+
+    if (enabled)
+    {
+        sSpatialIndexing = true;
+        mSpatialIndex = std::make_shared<SpatialIndex>();
+    }
+    else
+        mSpatialIndex = nullptr;
+}
+
+void Window::descendantGeometryChanged()
+{
+    if (mSpatialIndex)
+        mSpatialIndex->dirty = true;
+}
+
+Widget *Window::findWidget(const Vector2i &p)
+{
+    if (!mSpatialIndex)
+        return Widget::findWidget(p);
+
+    if (mSpatialIndex->dirty)
+        mSpatialIndex->build(this);
+
+    /* Children may overflow the window, the grid only covers its area */
+    const std::vector<Widget*>* cell = mSpatialIndex->cell(p - _pos);
+    if (!cell)
+        return Widget::findWidget(p);
+
+    Vector2i ap = p - _pos + absolutePosition();
+    for (auto it = cell->rbegin(); it != cell->rend(); ++it)
+    {
+        Widget *hit = *it;
+
+        bool inside = true;
+        for (Widget *w = hit; inside && w != this; w = w->parent())
+            inside = w->visible() && w->contains(ap - w->parent()->absolutePosition());
+
+        if (inside)
+            return hit->findWidget(ap - hit->parent()->absolutePosition());
+    }
+
+    return contains(p) ? this : nullptr;
 }
 
 bool Window::focusEvent(bool focused)
@@ -241,22 +225,101 @@ void Window::drawBodyTemp(SDL_Renderer* renderer)
   SDL_RenderDrawLine(renderer, ap.x + 0.5f, ap.y + hh - 1.5f, ap.x + width() - 0.5f, ap.y + hh - 1.5);
 }
 
+void Window::paintBody(NVGcontext* ctx, int realw, int realh, bool mouseFocus) const
+{
+  int ds = mTheme->mWindowDropShadowSize;
+  int ww = realw - 2 * ds;
+  int hh = realh - 2 * ds;
+
+  Vector2i mPos(ds, ds);
+
+  int cr = mTheme->mWindowCornerRadius;
+  int headerH = mTheme->mWindowHeaderHeight;
+
+  /* Draw window */
+  nvgSave(ctx);
+  nvgBeginPath(ctx);
+  nvgRoundedRect(ctx, mPos.x, mPos.y, ww, hh, cr);
+
+  nvgFillColor(ctx, (mouseFocus ? mTheme->mWindowFillFocused
+                                : mTheme->mWindowFillUnfocused).toNvgColor());
+  nvgFill(ctx);
+
+  /* Draw a drop shadow */
+  if (mDropShadowEnabled) {
+    NVGpaint shadowPaint = nvgBoxGradient(
+      ctx, mPos.x, mPos.y, ww, hh, cr * 2, ds * 2,
+      mTheme->mDropShadow.toNvgColor(),
+      mTheme->mTransparent.toNvgColor());
+
+    nvgSave(ctx);
+    nvgResetScissor(ctx);
+    nvgBeginPath(ctx);
+    nvgRect(ctx, mPos.x - ds, mPos.y - ds, ww + 2 * ds, hh + 2 * ds);
+    nvgRoundedRect(ctx, mPos.x, mPos.y, ww, hh, cr);
+    nvgPathWinding(ctx, NVG_HOLE);
+    nvgFillPaint(ctx, shadowPaint);
+    nvgFill(ctx);
+    nvgRestore(ctx);
+  }
+
+  /* Draw header */
+  NVGpaint headerPaint = nvgLinearGradient(
+    ctx, mPos.x, mPos.y, mPos.x,
+    mPos.y + headerH,
+    mTheme->mWindowHeaderGradientTop.toNvgColor(),
+    mTheme->mWindowHeaderGradientBot.toNvgColor());
+
+  nvgBeginPath(ctx);
+  nvgRoundedRect(ctx, mPos.x, mPos.y, ww, headerH, cr);
+
+  nvgFillPaint(ctx, headerPaint);
+  nvgFill(ctx);
+
+  nvgBeginPath(ctx);
+  nvgRoundedRect(ctx, mPos.x, mPos.y, ww, headerH, cr);
+  nvgStrokeColor(ctx, mTheme->mWindowHeaderSepTop.toNvgColor());
+
+  nvgSave(ctx);
+  nvgIntersectScissor(ctx, mPos.x, mPos.y, ww, 0.5f);
+  nvgStroke(ctx);
+  nvgRestore(ctx);
+
+  nvgBeginPath(ctx);
+  nvgMoveTo(ctx, mPos.x + 0.5f, mPos.y + headerH - 1.5f);
+  nvgLineTo(ctx, mPos.x + ww - 0.5f, mPos.y + headerH - 1.5);
+  nvgStrokeColor(ctx, mTheme->mWindowHeaderSepBot.toNvgColor());
+  nvgStroke(ctx);
+  nvgRestore(ctx);
+}
+
 void Window::drawBody(SDL_Renderer* renderer)
 {
-  int id = (mMouseFocus ? 0x1 : 0);
+  int id = (mMouseFocus ? 0x1 : 0) + (mDropShadowEnabled ? 0x2 : 0);
+  bool mouseFocus = mMouseFocus;
 
-  auto atx = std::find_if(_txs.begin(), _txs.end(), [id](AsyncTexturePtr const& p) { return p->id == id; });
+  /* Header and shadow keep their size, so only the window interior is stretched */
+  int ds = mTheme->mWindowDropShadowSize;
+  int side = ds + 2 * mTheme->mWindowCornerRadius + 2;
+  int top = ds + mTheme->mWindowHeaderHeight + 2;
+  PntRect insets{ side, top, side, side };
 
-  if (atx != _txs.end())
-    drawTexture(*atx, renderer);
-  else
-  {
-    AsyncTexturePtr newtx = std::make_shared<AsyncTexture>(id);
-    newtx->load(this, 0, 0, mMouseFocus);
-    _txs.push_back(newtx);
+  if (mGeometryBody
+      && mTheme->paintGeometry(renderer, absolutePosition() - Vector2i(ds, ds), size() + Vector2i(2 * ds, 2 * ds),
+                               [this, mouseFocus](NVGcontext* ctx, int w, int h) { paintBody(ctx, w, h, mouseFocus); }))
+    return;
+
+  const NinePatch* skin = mTheme->getSkin(renderer, Theme::SkinClass::Window, id,
+                                          Vector2i(2 * side + 4, top + side + 4), insets,
+                                          [this, mouseFocus](NVGcontext* ctx, int w, int h) { paintBody(ctx, w, h, mouseFocus); });
 
-    drawTexture(current_texture_, renderer);
+  if (skin->tex.tex)
+  {
+    Vector2i ap = absolutePosition();
+    SDL_RenderCopy(renderer, *skin, SDL_Rect{ ap.x - ds, ap.y - ds, width() + 2 * ds, height() + 2 * ds });
   }
+  else
+    drawBodyTemp(renderer);
 }
 
 void Window::draw(SDL_Renderer* renderer)
@@ -306,6 +369,7 @@ bool Window::mouseDragEvent(const Vector2i &, const Vector2i &rel,
         _pos += rel;
         _pos = _pos.cmax({ 0, 0 });
         _pos = _pos.cmin(parent()->size() - mSize);
+        invalidateGeometry();
         return true;
     }
     return false;
@@ -333,28 +397,4 @@ void Window::refreshRelativePlacement()
     /* Overridden in \ref Popup */
 }
 
-void Window::drawTexture(AsyncTexturePtr& texture, SDL_Renderer* renderer)
-{
-  if (texture)
-  {
-    texture->perform(renderer);
-
-    if (texture->tex.tex)
-    {
-      SDL_RenderCopy(renderer, texture->tex, absolutePosition());
-
-      if (!current_texture_ || texture->id != current_texture_->id)
-        current_texture_ = texture;
-    }
-    else if (current_texture_)
-    {
-      SDL_RenderCopy(renderer, current_texture_->tex, absolutePosition());
-    }
-    else
-      drawBodyTemp(renderer);
-  }
-  else
-    drawBodyTemp(renderer);
-}
-
 NAMESPACE_END(sdlgui)
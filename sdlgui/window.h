@@ -16,6 +16,8 @@
 
 NAMESPACE_BEGIN(sdlgui)
 
+class Popup;
+
 /**
  * \class Window window.h sdl_gui/window.h
  *
@@ -58,6 +60,20 @@ public:
     /// Center the window in the current \ref Screen
     void center();
 
+    /// Is hit testing accelerated by a spatial index?
+    bool spatialIndex() const { return mSpatialIndex != nullptr; }
+    /**
+     * \brief Accelerate \ref findWidget with a uniform grid over the window's descendants.
+     *
+     * Useful for windows with thousands of widgets. The grid is rebuilt after
+     * \ref performLayout and lazily whenever a descendant moves or the tree changes.
+     */
+    void setSpatialIndex(bool enabled);
+    Window& withSpatialIndex(bool enabled = true) { setSpatialIndex(enabled); return *this; }
+
+    /// Determine the widget located at the given position, using the spatial index when enabled
+    Widget *findWidget(const Vector2i &p) override;
+
     /// Draw the window
     void draw(SDL_Renderer* surface) override;
     virtual void drawBody(SDL_Renderer* renderer);
@@ -77,7 +93,13 @@ public:
     /// Handle a focus change event (default implementation: record the focus status, but do nothing)
     bool focusEvent(bool focused);
 
+    /// Return the popups anchored to this window; they are raised together with it
+    const std::vector<Popup *> &popups() const { return mPopups; }
+
 protected:
+    /// Detach the popups that are still anchored to this window
+    virtual ~Window();
+
     /// Internal helper function to maintain nested window position values; overridden in \ref Popup
     void refreshRelativePlacement();
 protected:
@@ -91,15 +113,15 @@ protected:
     bool mDrag;
     bool mDraggable = true;
     bool mDropShadowEnabled = true;
+    std::vector<Popup *> mPopups;
 
-    struct AsyncTexture;
-    typedef std::shared_ptr<AsyncTexture> AsyncTexturePtr;
-    std::vector<AsyncTexturePtr> _txs;
+    struct SpatialIndex;
+    std::shared_ptr<SpatialIndex> mSpatialIndex;
 
-    AsyncTexturePtr current_texture_ = nullptr;
+    void descendantGeometryChanged() override;
 
-private:
-    void drawTexture(AsyncTexturePtr& texture, SDL_Renderer* renderer);
+    /// Paint the window skin (body, header and drop shadow) into a NanoVG context of the given size
+    void paintBody(NVGcontext* ctx, int realw, int realh, bool mouseFocus) const;
 };
 
 NAMESPACE_END(sdlgui)
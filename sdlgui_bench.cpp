@@ -0,0 +1,703 @@
+/*
+    sdlgui/sdlgui_bench.cpp -- Micro and macro benchmarks for sdlgui
+
+    Runs headless on a software renderer, so it works on machines without
+    a display or GPU. Every benchmark reports p50/p99/mean wall time and the
+    number of heap allocations per iteration; --json stores the results so
+    runs on different commits can be compared.
+
+    Usage: sdlgui_bench [--json results.json] [--filter name] [--iterations N] [--frames N]
+
+    Adaptation for SDL by Dalerank <dalerankn8@gmail.com>
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+
+#include <sdlgui/screen.h>
+#include <sdlgui/window.h>
+#include <sdlgui/layout.h>
+#include <sdlgui/label.h>
+#include <sdlgui/button.h>
+#include <sdlgui/textbox.h>
+#include <sdlgui/theme.h>
+#include <sdlgui/graph.h>
+#include <sdlgui/plot.h>
+#include <sdlgui/imageview.h>
+#include <sdlgui/imagepanel.h>
+#include <sdlgui/vscrollpanel.h>
+#include <sdlgui/colorwheel.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#include <SDL.h>
+#else
+#include <SDL2/SDL.h>
+#endif
+
+#include "nanovg.h"
+#include "nanovg_rt.h"
+
+#undef main
+
+using namespace sdlgui;
+
+/* Count every heap allocation made by the process */
+static std::atomic<uint64_t> gAllocations(0);
+
+void* operator new(std::size_t size)
+{
+  gAllocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* p = std::malloc(size ? size : 1))
+    return p;
+  throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) { return operator new(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+namespace
+{
+
+struct BenchResult
+{
+  std::string name;
+  int iterations = 0;
+  double p50 = 0, p99 = 0, mean = 0; // milliseconds
+  double allocs = 0;                 // per iteration
+};
+
+struct BenchOptions
+{
+  std::string json;
+  std::string filter;
+  int iterations = 200;
+  int frames = 100;
+};
+
+typedef std::chrono::steady_clock Clock;
+
+/* Exposes the protected body painters of the standard widgets */
+struct BenchButton : public Button
+{
+  BenchButton(Widget* parent) : Button(parent, "Bench") {}
+  void paint(NVGcontext* ctx, int w, int h) const { paintBody(ctx, w, h, bodyStyle()); }
+};
+
+struct BenchWindow : public Window
+{
+  BenchWindow(Widget* parent) : Window(parent, "Bench") {}
+  void paint(NVGcontext* ctx, int w, int h) const { paintBody(ctx, w, h, true); }
+};
+
+/* Forces the decimated polyline to be rebuilt from the full series */
+struct BenchGraph : public Graph
+{
+  BenchGraph(Widget* parent) : Graph(parent) {}
+  size_t rebuild() { values(); return plotPoints().size(); }
+};
+
+class Bench
+{
+public:
+  Bench(const BenchOptions& options) : mOptions(options) {}
+
+  bool enabled(const std::string& name) const
+  {
+    return mOptions.filter.empty() || name.find(mOptions.filter) != std::string::npos;
+  }
+
+  /// Time \c iterations calls of \c fn, each sample is one call
+  template<typename Fn>
+  void run(const std::string& name, int iterations, Fn fn)
+  {
+    if (!enabled(name))
+      return;
+
+    std::vector<double> samples;
+    samples.reserve(iterations);
+
+    uint64_t allocs = gAllocations.load();
+    for (int i = 0; i < iterations; i++)
+    {
+      auto start = Clock::now();
+      fn(i);
+      samples.push_back(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+    }
+    allocs = gAllocations.load() - allocs;
+
+    BenchResult r;
+    r.name = name;
+    r.iterations = iterations;
+    r.allocs = double(allocs) / iterations;
+
+    double sum = 0;
+    for (double s : samples)
+      sum += s;
+    r.mean = sum / iterations;
+
+    std::sort(samples.begin(), samples.end());
+    r.p50 = samples[(samples.size() - 1) / 2];
+    r.p99 = samples[std::min(samples.size() - 1, (size_t)(samples.size() * 0.99))];
+
+    printf("%-32s %6d it  p50 %9.4f ms  p99 %9.4f ms  mean %9.4f ms  %10.1f allocs\n",
+           r.name.c_str(), r.iterations, r.p50, r.p99, r.mean, r.allocs);
+    mResults.push_back(r);
+  }
+
+  bool writeJson() const
+  {
+    if (mOptions.json.empty())
+      return true;
+
+    FILE* f = fopen(mOptions.json.c_str(), "w");
+    if (!f)
+      return false;
+
+    fprintf(f, "{\n  \"benchmarks\": [\n");
+    for (size_t i = 0; i < mResults.size(); i++)
+    {
+      const BenchResult& r = mResults[i];
+      fprintf(f, "    { \"name\": \"%s\", \"iterations\": %d, \"p50_ms\": %.6f, \"p99_ms\": %.6f, "
+                 "\"mean_ms\": %.6f, \"allocs_per_iter\": %.2f }%s\n",
+              r.name.c_str(), r.iterations, r.p50, r.p99, r.mean, r.allocs,
+              i + 1 < mResults.size() ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+    fclose(f);
+    return true;
+  }
+
+  const BenchOptions& options() const { return mOptions; }
+
+private:
+  BenchOptions mOptions;
+  std::vector<BenchResult> mResults;
+};
+
+SDL_Surface* createTarget()
+{
+  return SDL_CreateRGBSurfaceWithFormat(0, 1024, 768, 32, SDL_PIXELFORMAT_ARGB8888);
+}
+
+/* Software rasterization of the standard widget bodies, including context setup and readback */
+void benchRaster(Bench& bench, Screen* screen)
+{
+  auto& button = screen->wdg<BenchButton>();
+  auto& window = screen->wdg<BenchWindow>();
+
+  auto raster = [](int w, int h, const std::function<void(NVGcontext*)>& paint) {
+    NVGcontext* ctx = nvgCreateRT(NVG_DEBUG, w, h, 0);
+    nvgBeginFrame(ctx, w, h, 1.0f);
+    paint(ctx);
+    nvgEndFrame(ctx);
+    volatile unsigned char first = nvgReadPixelsRT(ctx)[0];
+    (void)first;
+    nvgDeleteRT(ctx);
+  };
+
+  int n = bench.options().iterations;
+  bench.run("rt_button_body_120x32", n, [&](int) {
+    raster(122, 34, [&](NVGcontext* ctx) { button.paint(ctx, 120, 32); });
+  });
+
+  bench.run("rt_window_body_400x300", n / 4 + 1, [&](int) {
+    raster(430, 330, [&](NVGcontext* ctx) { window.paint(ctx, 430, 330); });
+  });
+
+  bench.run("rt_fill_stroke_200x200", n, [&](int) {
+    raster(200, 200, [](NVGcontext* ctx) {
+      nvgBeginPath(ctx);
+      nvgRoundedRect(ctx, 10, 10, 180, 180, 8);
+      nvgFillPaint(ctx, nvgLinearGradient(ctx, 0, 0, 0, 200, nvgRGBA(255, 255, 255, 32), nvgRGBA(0, 0, 0, 32)));
+      nvgFill(ctx);
+      nvgStrokeColor(ctx, nvgRGBA(0, 0, 0, 48));
+      nvgStroke(ctx);
+    });
+  });
+
+  bench.run("button_draw_skin_miss", n, [&](int) {
+    screen->theme()->invalidateSkins();
+    button.draw(screen->sdlRenderer());
+  });
+
+  screen->removeChild(&button);
+  screen->removeChild(&window);
+}
+
+void benchText(Bench& bench, Screen* screen)
+{
+  SDL_Renderer* renderer = screen->sdlRenderer();
+  Theme* theme = screen->theme();
+  int n = bench.options().iterations;
+
+  bench.run("theme_getTexAndRectUtf8", n, [&](int i) {
+    Texture tx;
+    std::string text = "Benchmark label " + std::to_string(i);
+    theme->getTexAndRectUtf8(renderer, tx, 0, 0, text.c_str(), "sans", 20, Color(255, 255));
+    SDL_DestroyTexture(tx.tex);
+  });
+
+  bench.run("theme_getUtf8Bounds", n * 10, [&](int) {
+    int w, h;
+    theme->getUtf8Bounds("sans", 20, "The quick brown fox jumps over the lazy dog", &w, &h);
+  });
+}
+
+void benchLayout(Bench& bench, Screen* screen)
+{
+  SDL_Renderer* renderer = screen->sdlRenderer();
+  int n = bench.options().iterations / 10 + 1;
+
+  auto& window = screen->window("Layout", Vector2i(0, 0));
+  for (int i = 0; i < 500; i++)
+    window.button("Button " + std::to_string(i));
+
+  window.withLayout<BoxLayout>(Orientation::Vertical, Alignment::Fill, 4, 2);
+  bench.run("layout_box_500", n, [&](int) { window.performLayout(renderer); });
+
+  window.withLayout<GridLayout>(Orientation::Horizontal, 10, Alignment::Fill, 4, 2);
+  bench.run("layout_grid_500", n, [&](int) { window.performLayout(renderer); });
+
+  screen->removeChild(&window);
+}
+
+/* 8 levels of nesting with 6 children each; the query lands in the last, deepest branch */
+void benchFindWidget(Bench& bench, Screen* screen)
+{
+  auto& root = screen->wdg<Widget>();
+  root.setPosition(Vector2i(0, 0));
+  root.setSize(Vector2i(1024, 768));
+
+  Widget* branch = &root;
+  for (int depth = 0; depth < 8; depth++)
+  {
+    Widget* last = nullptr;
+    for (int i = 0; i < 6; i++)
+    {
+      last = branch->add<Widget>();
+      last->setPosition(Vector2i(1, 1));
+      last->setSize(branch->size() - Vector2i(2, 2));
+    }
+    branch = last;
+  }
+
+  bench.run("findWidget_depth8", bench.options().iterations * 50, [&](int i) {
+    volatile Widget* w = root.findWidget(Vector2i(20 + i % 100, 20 + i % 50));
+    (void)w;
+  });
+
+  screen->removeChild(&root);
+}
+
+/* Type dispatch: parent window lookup from a deep leaf and a click inside a 200 button radio group */
+void benchDispatch(Bench& bench, Screen* screen)
+{
+  auto& window = screen->window("Dispatch", Vector2i(0, 0));
+
+  Widget* leaf = &window;
+  for (int depth = 0; depth < 8; depth++)
+    leaf = leaf->add<Widget>();
+
+  bench.run("window_lookup_depth8", bench.options().iterations * 50, [&](int) {
+    volatile Window* w = leaf->window();
+    (void)w;
+  });
+
+  auto& group = window.widget();
+  std::vector<Button*> radios;
+  for (int i = 0; i < 200; i++)
+  {
+    Button* b = group.add<Button>("Radio " + std::to_string(i));
+    b->setFlags(Button::RadioButton);
+    radios.push_back(b);
+  }
+
+  bench.run("radio_group_click_200", bench.options().iterations * 10, [&](int i) {
+    Button* b = radios[i % radios.size()];
+    b->mouseButtonEvent(b->position(), SDL_BUTTON_LEFT, true, 0);
+    b->mouseButtonEvent(b->position(), SDL_BUTTON_LEFT, false, 0);
+  });
+
+  screen->removeChild(&window);
+}
+
+/* Construction and teardown of 10k widget trees, from the heap and from a widget arena */
+void benchTrees(Bench& bench, Screen* screen)
+{
+  const int trees = 5;
+  for (bool arena : { false, true })
+  {
+    std::string suffix = arena ? "arena" : "heap";
+    std::vector<Widget*> roots;
+
+    bench.run("tree_build_10k_" + suffix, trees, [&](int) {
+      screen->setWidgetArena(arena);
+      auto& root = screen->widget();
+      for (int g = 0; g < 100; g++)
+      {
+        auto& group = root.widget();
+        for (int i = 0; i < 99; i++)
+          group.label("Label");
+      }
+      screen->setWidgetArena(false);
+      roots.push_back(&root);
+    });
+
+    if (!roots.empty())
+      bench.run("tree_teardown_10k_" + suffix, (int)roots.size(), [&](int i) {
+        screen->removeChild(roots[i]);
+      });
+  }
+}
+
+/* Per-frame style id lookups in a 10k widget tree; the queried label is the last one added */
+void benchIdLookup(Bench& bench, Screen* screen)
+{
+  auto& root = screen->widget();
+  for (int g = 0; g < 100; g++)
+  {
+    auto& group = root.widget();
+    for (int i = 0; i < 100; i++)
+      group.label("Label").withId("label_" + std::to_string(g) + "_" + std::to_string(i));
+  }
+
+  bench.run("gfind_10k", bench.options().iterations * 50, [&](int) {
+    volatile Widget* w = root.gfind("label_99_99");
+    (void)w;
+  });
+
+  bench.run("gfind_typed_10k", bench.options().iterations * 50, [&](int) {
+    volatile Label* l = root.gfind<Label>("label_99_99");
+    (void)l;
+  });
+
+  screen->removeChild(&root);
+}
+
+/* Builds a scene of windows holding labels, buttons and text boxes through the fluent API */
+void buildScene(Screen* screen, int widgets)
+{
+  const int perWindow = 100;
+  for (int w = 0; w * perWindow < widgets; w++)
+  {
+    auto& window = screen->window("Window " + std::to_string(w), Vector2i((w * 37) % 800, (w * 23) % 600));
+    window.withLayout<GroupLayout>();
+    for (int i = 0; i < perWindow - 1; i += 3)
+    {
+      window.label("Label " + std::to_string(i));
+      window.button("Button " + std::to_string(i));
+      window.textbox("Text " + std::to_string(i));
+    }
+  }
+  screen->performLayout();
+}
+
+/* Streaming graph: producer pushes plus the incremental column upload on draw */
+void benchGraph(Bench& bench, Screen* screen)
+{
+  SDL_Renderer* renderer = screen->sdlRenderer();
+  auto& graph = screen->wdg<Graph>("stream");
+  graph.setFixedSize(Vector2i(400, 120));
+  graph.setSize(Vector2i(400, 120));
+  graph.setStreaming(4096, 4);
+
+  int n = bench.options().iterations;
+  bench.run("graph_stream_push_64_draw", n, [&](int i) {
+    for (int k = 0; k < 64; k++)
+      graph.push(0.5f + 0.4f * std::sin((i * 64 + k) * 0.01f));
+    graph.draw(renderer);
+  });
+
+  bench.run("graph_stream_push_mt_4x10k", 5, [&](int) {
+    std::vector<std::thread> producers;
+    for (int t = 0; t < 4; t++)
+      producers.emplace_back([&graph, t] {
+        for (int k = 0; k < 10000; k++)
+          graph.push((k + t) % 100 / 100.f);
+      });
+    for (auto& p : producers)
+      p.join();
+    graph.draw(renderer);
+  });
+
+  screen->removeChild(&graph);
+
+  /* Decimation of a large static series down to the widget width */
+  auto& plot = screen->wdg<BenchGraph>();
+  plot.setSize(Vector2i(180, 45));
+  std::vector<float> big(1000000);
+  for (size_t i = 0; i < big.size(); i++)
+    big[i] = 0.5f + 0.4f * std::sin(i * 0.001f) + ((i * 2654435761u) % 1000) / 20000.f;
+  plot.setValues(big);
+
+  for (auto mode : { Graph::Decimation::MinMax, Graph::Decimation::LTTB })
+  {
+    plot.setDecimation(mode);
+    bench.run(std::string("graph_decimate_1m_") + (mode == Graph::Decimation::MinMax ? "minmax" : "lttb"), n / 10 + 1, [&](int) {
+      volatile size_t points = plot.rebuild();
+      (void)points;
+    });
+  }
+
+  screen->removeChild(&plot);
+
+  /* Four 1M sample series redrawn while zooming and panning */
+  auto& multi = screen->wdg<Plot>("multi");
+  multi.setSize(Vector2i(600, 200));
+  for (int s = 0; s < 4; s++)
+    multi.setSeriesValues(multi.addSeries("s" + std::to_string(s), Color(255, 64 * s, 0, 255)), big);
+
+  bench.run("plot_zoom_pan_4x1m", n, [&](int i) {
+    multi.scrollEvent(multi.position() + Vector2i(i % 600, 10), Vector2f(0, (i / 20) % 2 ? -1.f : 1.f));
+    multi.mouseDragEvent(multi.position(), Vector2i(3, 0), SDL_BUTTON_LEFT, 0);
+    multi.draw(renderer);
+  });
+
+  screen->removeChild(&multi);
+}
+
+/* Tiled ImageView on an image larger than a single texture: zoom out and pan every frame */
+void benchImageView(Bench& bench, Screen* screen)
+{
+  SDL_Renderer* renderer = screen->sdlRenderer();
+  SDL_Surface* image = SDL_CreateRGBSurfaceWithFormat(0, 8192, 4096, 32, SDL_PIXELFORMAT_ARGB8888);
+  for (int y = 0; y < image->h; y++)
+  {
+    uint32_t* row = (uint32_t*)((uint8_t*)image->pixels + y * image->pitch);
+    for (int x = 0; x < image->w; x++)
+      row[x] = 0xff000000u | ((x & 0xff) << 16) | ((y & 0xff) << 8) | ((x ^ y) & 0xff);
+  }
+
+  auto& window = screen->wdg<Window>("image");
+  window.setSize(Vector2i(800, 600));
+  auto& view = window.wdg<ImageView>(image);
+  view.setSize(Vector2i(800, 600));
+  SDL_FreeSurface(image);
+  waitAsyncJobs();
+
+  bench.run("imageview_tiled_zoom_pan_8kx4k", bench.options().frames, [&](int i) {
+    view.zoom((i / 16) % 2 ? 1 : -1, Vector2f(400, 300));
+    view.moveOffset(Vector2f(float(i % 7 - 3), float(i % 5 - 2)));
+    view.draw(renderer);
+  });
+
+  /* 64x64 visible pixels with grid and per-pixel text, panned by whole pixels so most strings stay cached */
+  view.setGridThreshold(8);
+  view.setPixelInfoThreshold(8);
+  view.setPixelInfoCallback([](const Vector2i& p) {
+    return std::make_pair(std::to_string(p.x & 0xff) + "\n" + std::to_string(p.y & 0xff), Color(255, 255));
+  });
+  view.setScale(600.f / 64);
+  bench.run("imageview_pixel_info_64x64", bench.options().frames, [&](int i) {
+    view.setOffset(Vector2f(-float(i % 32) * view.scale(), 0));
+    view.draw(renderer);
+  });
+
+  screen->removeChild(&window);
+
+  /* 4k float RGBA through the CPU display pipeline: pans by whole pixels, with an exposure change every 16 frames */
+  std::vector<float> hdr(size_t(4096) * 2048 * 4);
+  for (size_t k = 0; k < hdr.size(); k++)
+    hdr[k] = float((k * 2654435761u) % 1024) / 256.f;
+
+  auto& hdrWindow = screen->wdg<Window>("hdr");
+  hdrWindow.setSize(Vector2i(800, 600));
+  auto& hdrView = hdrWindow.wdg<ImageView>((SDL_Texture*)nullptr);
+  hdrView.setSize(Vector2i(800, 600));
+  hdrView.bindImage(hdr.data(), 4096, 2048, 4);
+  hdrView.setScale(1.5f);
+  hdrView.setFilter(ImageView::Filter::Bilinear);
+
+  bench.run("imageview_float_pan_exposure_4kx2k", bench.options().frames, [&](int i) {
+    hdrView.moveOffset(Vector2f(float(i % 7 - 3), float(i % 5 - 2)));
+    if (i % 16 == 0)
+      hdrView.setExposure(float((i / 16) % 4) - 1.f);
+    hdrView.draw(renderer);
+  });
+
+  screen->removeChild(&hdrWindow);
+}
+
+/* 100k entry gallery inside a scroll panel: draw cost should follow the visible rows only */
+void benchImagePanel(Bench& bench, Screen* screen)
+{
+  SDL_Renderer* renderer = screen->sdlRenderer();
+  SDL_Texture* icon = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, 64, 64);
+
+  ListImages images(100000);
+  for (ImageInfo& info : images)
+  {
+    info.tex = icon;
+    info.w = info.h = 64;
+  }
+
+  auto& window = screen->wdg<Window>("gallery");
+  auto& scroll = window.wdg<VScrollPanel>();
+  auto& panel = scroll.wdg<ImagePanel>(images);
+  window.setPosition(Vector2i(0, 0));
+  window.setFixedSize(Vector2i(330, 400));
+  scroll.setFixedSize(Vector2i(320, 380));
+  screen->performLayout();
+
+  bench.run("imagepanel_scroll_draw_100k", bench.options().frames, [&](int i) {
+    scroll.scrollEvent(Vector2i(10, 10), Vector2f(0, (i / 50) % 2 ? 1.f : -1.f));
+    window.draw(renderer);
+  });
+
+  bench.run("imagepanel_hit_100k", bench.options().iterations * 10, [&](int i) {
+    panel.mouseMotionEvent(Vector2i((i * 37) % 320, (i * 53) % 400), Vector2i(0, 0), 0, 0);
+  });
+
+  screen->removeChild(&window);
+  SDL_DestroyTexture(icon);
+}
+
+/* ColorWheel drags: triangle drags only move the selector, ring drags re-raster the triangle */
+void benchColorWheel(Bench& bench, Screen* screen)
+{
+  SDL_Renderer* renderer = screen->sdlRenderer();
+  auto& wheel = screen->wdg<ColorWheel>();
+  wheel.setSize(Vector2i(200, 200));
+  wheel.draw(renderer);
+
+  int n = bench.options().iterations;
+  bench.run("colorwheel_drag_triangle", n, [&](int i) {
+    wheel.mouseButtonEvent(Vector2i(100, 100), SDL_BUTTON_LEFT, true, 0);
+    wheel.mouseDragEvent(Vector2i(95 + i % 10, 95 + i % 7), Vector2i(1, 0), SDL_BUTTON_LEFT, 0);
+    wheel.draw(renderer);
+  });
+
+  bench.run("colorwheel_drag_ring", n, [&](int i) {
+    float a = i * 0.05f;
+    Vector2i p(100 + int(std::cos(a) * 85), 100 + int(std::sin(a) * 85));
+    wheel.mouseButtonEvent(p, SDL_BUTTON_LEFT, true, 0);
+    wheel.draw(renderer);
+  });
+
+  screen->removeChild(&wheel);
+}
+
+void benchScene(Bench& bench, int widgets)
+{
+  std::string suffix = std::to_string(widgets / 1000) + "k";
+
+  SDL_Surface* target = createTarget();
+  bench.run("scene_build_" + suffix, 5, [&](int) {
+    Screen* screen = new Screen(target);
+    buildScene(screen, widgets);
+    delete screen;
+  });
+
+  Screen* screen = new Screen(target);
+  buildScene(screen, widgets);
+  screen->flushAsyncTextures();
+
+  bench.run("scene_frame_" + suffix, bench.options().frames, [&](int) {
+    SDL_RenderClear(screen->sdlRenderer());
+    screen->drawAll();
+  });
+
+  for (bool mirror : { false, true })
+  {
+    screen->setGeometryMirror(mirror);
+    bench.run("scene_hit_" + suffix + (mirror ? "_mirror" : ""), bench.options().iterations * 10, [&](int i) {
+      volatile Widget* w = screen->findWidget(Vector2i((i * 37) % 1024, (i * 53) % 768));
+      (void)w;
+    });
+  }
+
+  bench.run("scene_frame_" + suffix + "_mirror", bench.options().frames, [&](int) {
+    SDL_RenderClear(screen->sdlRenderer());
+    screen->drawAll();
+  });
+
+  /* Raster jobs started by the frames must not outlive the renderer the screen owns */
+  waitAsyncJobs();
+  delete screen;
+  SDL_FreeSurface(target);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  BenchOptions options;
+  for (int i = 1; i < argc; i++)
+  {
+    std::string arg = argv[i];
+    if (arg == "--json" && i + 1 < argc)
+      options.json = argv[++i];
+    else if (arg == "--filter" && i + 1 < argc)
+      options.filter = argv[++i];
+    else if (arg == "--iterations" && i + 1 < argc)
+      options.iterations = std::max(1, atoi(argv[++i]));
+    else if (arg == "--frames" && i + 1 < argc)
+      options.frames = std::max(1, atoi(argv[++i]));
+    else
+    {
+      std::cerr << "Usage: " << argv[0] << " [--json file] [--filter name] [--iterations N] [--frames N]" << std::endl;
+      return 1;
+    }
+  }
+
+  if (SDL_Init(0) != 0)
+  {
+    std::cerr << "Could not initialize SDL: " << SDL_GetError() << std::endl;
+    return 1;
+  }
+
+  Bench bench(options);
+  try
+  {
+    SDL_Surface* target = createTarget();
+    Screen* screen = new Screen(target, "bench");
+
+    benchRaster(bench, screen);
+    benchText(bench, screen);
+    benchLayout(bench, screen);
+    benchFindWidget(bench, screen);
+    benchDispatch(bench, screen);
+    benchTrees(bench, screen);
+    benchIdLookup(bench, screen);
+    benchGraph(bench, screen);
+    benchImageView(bench, screen);
+    benchImagePanel(bench, screen);
+    benchColorWheel(bench, screen);
+
+    waitAsyncJobs();
+    delete screen;
+    SDL_FreeSurface(target);
+
+    benchScene(bench, 1000);
+    benchScene(bench, 10000);
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << "Benchmark failed: " << e.what() << std::endl;
+    SDL_Quit();
+    return 1;
+  }
+
+  bool ok = bench.writeJson();
+  if (!ok)
+    std::cerr << "Could not write " << options.json << std::endl;
+
+  SDL_Quit();
+  return ok ? 0 : 1;
+}